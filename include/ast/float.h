@@ -18,6 +18,7 @@ class FloatLiteral : public Node {
   // void interpret() override;
 
   float getValue() const;
+  int getLine() const;
 };
 
 } /* namespace ast */
@@ -17,6 +17,7 @@ class Identifier : public Node {
   ~Identifier() = default;
 
   std::string getValue() const;
+  int getLine() const;
 
   std::string toString() const override;
 };
@@ -17,6 +17,7 @@ class IntegerLiteral : public Node {
   ~IntegerLiteral() = default;
 
   int32_t getValue() const;
+  int getLine() const;
 };
 
 } /* namespace ast */
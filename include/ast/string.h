@@ -17,6 +17,7 @@ class StringLiteral : public Node {
   ~StringLiteral() = default;
 
   std::string getValue() const;
+  int getLine() const;
 };
 
 } /* namespace ast */
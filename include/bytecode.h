@@ -0,0 +1,53 @@
+#ifndef _FF_BYTECODE_H_
+#define _FF_BYTECODE_H_ 1
+
+#include <ff/compiler/compiler.h>
+#include <ff/utils/mapped_file.h>
+#include <ff/code.h>
+#include <ff/ref.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ff {
+
+/* Precompiled bytecode (.ffc) files
+ * Layout (all integers are little-endian, varints are LEB128):
+ *   header:    magic "FFC\0", u16 format version, u16 opcode count
+ *   code:      root Code
+ * Code:        filename, bytecode, global names (OP_*_GLOBAL operands index them),
+ *              symbol names (name operands of field and member instructions index them), constants,
+ *              inline cache count, line table, module references (name, path)
+ * Constants:   u8 tag followed by value (functions contain args, return type annotation and their own Code)
+ * Imported modules are stored as references and are loaded again when the file is read.
+ * Module images (used by the module compile cache) append to the root Code the compiler's type information:
+ *   variables: module variable, import count, imported module variables
+ * Variable:    name, type annotation, u8 isConst, fields (key, Variable)
+ */
+namespace bytecode {
+
+constexpr const char* kExtension = ".ffc";
+constexpr uint16_t kFormatVersion = 4; // Must be bumped on any change to the layout or opcode numbering
+
+std::vector<uint8_t> serialize(Ref<Code> code);
+Ref<Code> deserialize(const std::string& filename, const uint8_t* data, size_t size); // Copies bytecode out of data
+
+void save(Ref<Code> code, const std::string& filename);
+Ref<Code> load(const std::string& filename); // Maps the file, loaded code executes from the mapping
+
+bool isBytecodeFile(const std::string& filename);
+
+/* Compiled module together with what the compiler knows about it, enough to import it without compiling */
+struct ModuleImage {
+  Ref<Code> code;
+  Compiler::Variable var;                  // Type information of the module itself
+  std::vector<Compiler::Variable> imports; // Modules imported by it (var.name is the module name)
+};
+
+std::vector<uint8_t> serializeModule(const ModuleImage& module);
+ModuleImage deserializeModule(const std::string& filename, const uint8_t* data, size_t size, Ref<MappedFile> image = {});
+
+} /* namespace bytecode */
+} /* namespace ff */
+
+#endif /* _FF_BYTECODE_H_ */
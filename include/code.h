@@ -1,7 +1,9 @@
 #ifndef _FF_CODE_H_
 #define _FF_CODE_H_ 1
 
+#include <ff/utils/mapped_file.h>
 #include <ff/object.h>
+#include <ff/symbol.h>
 #include <ff/ref.h>
 #include <ff/abi.h>
 #include <cstdint>
@@ -9,6 +11,7 @@
 #include <cstdio>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <map>
 
 namespace ff {
@@ -31,9 +34,12 @@ enum Opcode {
   OP_GET_LOCAL,
   OP_SET_LOCAL,
   OP_SET_LOCAL_REF,
+  OP_REF_LOCAL,
   OP_GET_FIELD,
   OP_SET_FIELD,
   OP_SET_FIELD_REF,
+  OP_GET_SLOT,
+  OP_SET_SLOT,
   OP_GET_STATIC,
   OP_JUMP,
   OP_JUMP_TRUE,
@@ -41,6 +47,7 @@ enum Opcode {
   OP_LOOP,
   OP_CALL,
   OP_CALL_MEMBER,
+  OP_TAIL_CALL,
   OP_RETURN,
   OP_CAST,
   OP_PRINT,
@@ -61,24 +68,100 @@ enum Opcode {
   OP_NOT,
   OP_INC,
   OP_DEC,
+  OP_INC_LOCAL,
+  OP_DEC_LOCAL,
   OP_BREAKPOINT,
+  OP_HALT,
 };
 
 std::string opcodeToString(const Opcode op);
+size_t getOperandSize(const Opcode op); // Size in bytes of operands that follow the opcode
+
+/* Per-instruction cache of member lookups (OP_CALL_MEMBER, OP_GET_FIELD, OP_GET_SLOT, OP_SET_SLOT)
+ * Entry is valid while fields of the searched objects keep the recorded versions.
+ * Field of a class instance is cached as its slot, receiver of such entry is the class of the instance,
+ * so the entry is shared by all instances of the class (see ClassInstance).
+ */
+struct InlineCache {
+  static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+  struct Entry {
+    const Object* receiver = nullptr;   // Object whose fields are searched first (receiver, its class or its type)
+    uint64_t receiverVersion = 0;
+    const Object* owner = nullptr;      // Object where member was found, if it's not the receiver
+    uint64_t ownerVersion = 0;
+    Ref<Object> member;
+    bool implicitSelf = false;
+    uint32_t slot = kNoSlot;
+  };
+
+  static constexpr size_t kEntryCount = 4;
+
+  Entry entries[kEntryCount];
+  uint8_t nextEntry = 0;
+
+  inline Entry* find(const Object* receiver) {
+    for (auto& entry : entries) {
+      if (entry.receiver == receiver
+          && entry.slot == kNoSlot
+          && entry.receiverVersion == receiver->getFieldsVersion()
+          && (!entry.owner || entry.ownerVersion == entry.owner->getFieldsVersion())) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  inline Entry* findSlot(const Object* classObject) {
+    for (auto& entry : entries) {
+      if (entry.receiver == classObject && entry.slot != kNoSlot && entry.receiverVersion == classObject->getFieldsVersion()) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  inline Entry& replace() {
+    Entry& entry = entries[nextEntry];
+    nextEntry = (nextEntry + 1) % kEntryCount;
+    return entry;
+  }
+};
 
-class Code {
+class Code : public RefCounted {
  private:
-  struct LineInfo {
-    size_t startOffset;
-    int line;
+  /* Line table is a stream of (offset delta, line delta) varint pairs, one per line change
+   * Every kLineCheckpointInterval entries absolute state is saved to a checkpoint,
+   * so getLine can binary search checkpoints and decode only a few entries after that
+   */
+  struct LineCheckpoint {
+    uint32_t offset;
+    int32_t line;
+    uint32_t position; // Index in m_lineTable right after the entry
   };
 
+  static constexpr size_t kLineCheckpointInterval = 16;
+
  private:
   std::vector<uint8_t> m_code;
+  const uint8_t* m_image = nullptr; // Bytecode inside a mapped file, used instead of m_code
+  size_t m_imageSize = 0;
+  Ref<MappedFile> m_imageFile;
   std::vector<Ref<Object>> m_constants;
-  std::vector<LineInfo> m_lines;
+  std::vector<uint32_t> m_globals; // Operand of OP_*_GLOBAL -> process-wide global slot
+  std::unordered_map<uint32_t, uint32_t> m_globalIndex;
+  std::vector<Symbol> m_symbols; // Name operand of field and member instructions -> symbol
+  std::unordered_map<Symbol, uint32_t, Symbol::Hash> m_symbolIndex;
+  std::unordered_multimap<size_t, unsigned> m_constantIndex; // Constant hash -> index in m_constants
+  std::vector<InlineCache> m_inlineCaches;
+  std::vector<uint8_t> m_lineTable;
+  std::vector<LineCheckpoint> m_lineCheckpoints;
+  size_t m_lineCount = 0;
+  uint32_t m_lastLineOffset = 0;
+  int32_t m_lastLine = 0;
   // std::vector<Local> m_locals;
   std::map<std::string, Ref<Object>> m_modules;
+  std::map<std::string, std::string> m_modulePaths; // Files of modules imported directly by this code
 
   std::string m_filename;
   size_t m_readIndex = 0;
@@ -89,16 +172,37 @@ class Code {
   Code(Code&&) = default;
   ~Code() = default;
 
-  size_t size() const;
+  inline size_t size() const {
+    return m_image ? m_imageSize : m_code.size();
+  }
+
+  inline const uint8_t* data() const {
+    return m_image ? m_image : m_code.data();
+  }
+
+  void append(const uint8_t* data, size_t size);
+  void setImage(Ref<MappedFile> file, const uint8_t* data, size_t size); // Executes bytecode directly from a mapped file
 
   Ref<Object> getConstant(unsigned index);
   unsigned addConstant(Ref<Object> constant);
   std::vector<Ref<Object>>& getConstants();
 
-  void addModule(const std::string& name, Ref<Object> module);
+  uint32_t addGlobal(uint32_t slot);
+  const std::vector<uint32_t>& getGlobals() const;
+
+  uint32_t addSymbol(const Symbol& symbol);
+  const Symbol& getSymbol(uint32_t index) const;
+  const std::vector<Symbol>& getSymbols() const;
+
+  uint32_t addInlineCache();
+  size_t getInlineCacheCount() const;
+  InlineCache& getInlineCache(uint32_t index);
+
+  void addModule(const std::string& name, Ref<Object> module, const std::string& path = "");
   bool hasModule(const std::string& name);
   Ref<Object> getModule(const std::string& name);
   std::map<std::string, Ref<Object>>& getModules();
+  const std::map<std::string, std::string>& getModulePaths() const;
 
   uint8_t& operator [](unsigned index);
   uint8_t operator [](unsigned index) const;
@@ -110,6 +214,10 @@ class Code {
 
   std::string getFilename() const;
   int getLine(unsigned offset) const;
+  void setLine(int line); // Marks code pushed after this call as belonging to line
+  size_t getLineTableSize() const;
+  const std::vector<uint8_t>& getLineTable() const;
+  void setLineTable(const uint8_t* data, size_t size);
   void pushInstruction(uint8_t op, int line = -1);
 
   void disassemble(const std::string& prefix = "");
@@ -127,47 +235,47 @@ class Code {
 
 template <>
 inline uint8_t Code::read<uint8_t>() {
-  return m_code[m_readIndex++];
+  return data()[m_readIndex++];
 }
 
 template <>
 inline int8_t Code::read<int8_t>() {
-  return m_code[m_readIndex++];
+  return data()[m_readIndex++];
 }
 
 template <>
 inline int16_t Code::read<int16_t>() {
   abi::N32 n;
-  n.u8[0] = m_code[m_readIndex++];
-  n.u8[1] = m_code[m_readIndex++];
+  n.u8[0] = data()[m_readIndex++];
+  n.u8[1] = data()[m_readIndex++];
   return n.i16[0];
 }
 
 template <>
 inline uint16_t Code::read<uint16_t>() {
   abi::N32 n;
-  n.u8[0] = m_code[m_readIndex++];
-  n.u8[1] = m_code[m_readIndex++];
+  n.u8[0] = data()[m_readIndex++];
+  n.u8[1] = data()[m_readIndex++];
   return n.u16[0];
 }
 
 template <>
 inline int32_t Code::read<int32_t>() {
   abi::N32 n;
-  n.u8[0] = m_code[m_readIndex++];
-  n.u8[1] = m_code[m_readIndex++];
-  n.u8[2] = m_code[m_readIndex++];
-  n.u8[3] = m_code[m_readIndex++];
+  n.u8[0] = data()[m_readIndex++];
+  n.u8[1] = data()[m_readIndex++];
+  n.u8[2] = data()[m_readIndex++];
+  n.u8[3] = data()[m_readIndex++];
   return n.i32;
 }
 
 template <>
 inline uint32_t Code::read<uint32_t>() {
   abi::N32 n;
-  n.u8[0] = m_code[m_readIndex++];
-  n.u8[1] = m_code[m_readIndex++];
-  n.u8[2] = m_code[m_readIndex++];
-  n.u8[3] = m_code[m_readIndex++];
+  n.u8[0] = data()[m_readIndex++];
+  n.u8[1] = data()[m_readIndex++];
+  n.u8[2] = data()[m_readIndex++];
+  n.u8[3] = data()[m_readIndex++];
   return n.u32;
 }
 
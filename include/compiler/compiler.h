@@ -32,9 +32,12 @@ class Compiler {
     static Variable fromObject(const std::string& name, Ref<Object> object);
   };
 
+  using ClassShape = std::map<std::string, uint32_t>; // Slot of every instance field of a class (see Class::Shape)
+
   struct TypeInfo {
     Ref<TypeAnnotation> type = TypeAnnotation::any();
     Variable* var = nullptr;
+    const ClassShape* shape = nullptr; // Shape of the class of the value, if it is known
   };
 
   struct ModuleInfo {
@@ -57,6 +60,8 @@ class Compiler {
     bool isFunctionScope = false;
     Ref<TypeAnnotation> returnType = TypeAnnotation::any();
     std::vector<Ref<TypeAnnotation>> returnStatements;
+    int argCount = 0; // Arguments are the first locals of a function scope
+    std::string selfClass; // Class of the method compiled in the scope, its first argument is the instance
   };
 
   struct LoopRecord {
@@ -73,6 +78,9 @@ class Compiler {
   std::vector<std::string> m_imports;                 // List of imported modules, to prevent reimports and circular dependencies
   std::string m_thisModuleName;                       // Current module
   std::string m_parentModuleName;                     // Module that imports this module (assuming that the module is compiled)
+  bool m_copyElision;                                 // Config 'copy_elision'
+  std::map<std::string, ClassShape> m_classShapes;    // Classes declared at the top level of this file
+  std::string m_methodClass;                          // Class whose method is about to be compiled
 
  public:
   Compiler();
@@ -85,6 +93,8 @@ class Compiler {
   std::map<std::string, Variable>& getGlobals();
   std::vector<std::string>& getImports();
 
+  static std::vector<std::string> getImportPaths(const std::string& filename); // Folders imports of filename are searched in
+
  private:
   Ref<Code>& getCode();
   std::vector<Variable>& getLocals();
@@ -92,7 +102,18 @@ class Compiler {
   std::vector<Variable>::iterator findLocal(const std::string& name);
   bool isTopScope() const;
 
-  /* Returns generated value type */
+  /* Returns generated value type
+   * Values have copy semantics, so reading a variable or a literal emits OP_COPY, which calls __copy__ for
+   * anything that isn't an unboxed int, float or bool. copyValue is false when the consumer only reads
+   * the value during the operation and doesn't keep it, so the copy can't be observed and isn't emitted:
+   *   - operands of binary and unary operators, printed values, callees
+   *   - literals: as operands of built-in operators, in discarded expression statements, in casts
+   *   - arguments of built-in methods that only read them (NativeFunction::borrowsArgs),
+   *     called on a receiver of a known built-in type whose instances have no fields (not dict)
+   * Literals are copied whenever they may be mutated or kept (e.g. ++, ref, call arguments, assignments),
+   * otherwise the constant itself would change. Config 'copy_elision' set to 0 disables elision
+   * of literal and argument copies.
+   */
   Ref<TypeAnnotation> evalNode(ast::Node* node, bool copyValue = true, bool isModule = false, bool saveToVariable = true);
 
   void beginScope();
@@ -107,12 +128,17 @@ class Compiler {
   LoopRecord& getLoop();
 
   void emitConstant(Ref<Object> obj);
+  void emitGlobal(Opcode op, const std::string& name);
+  void emitMember(Opcode op, const std::string& name);
+  void emitField(Opcode op, const std::string& name); // OP_SET_FIELD or OP_SET_FIELD_REF, expects [ object, value ]
+  void emitSlot(Opcode op, uint32_t slot, const std::string& name);
   void emitCall(const std::string& callee);
   uint16_t emitJump(Opcode op);
   void patchJump(int offset);
   void patchRemoteJump(int offset, int jump);
   void emitLoop(int loopStart);
 
+  Variable* resolveLocal(const std::string& name, uint32_t& index);
   Ref<TypeAnnotation> resolveVariable(const std::string& name, Opcode local = OP_GET_LOCAL, Opcode global = OP_GET_GLOBAL, bool checkIsConst = false);
   Ref<TypeAnnotation> getVariableType(const std::string& name);
   Ref<TypeAnnotation> defineLocal(Variable var, int line = 0, ast::Node* value = nullptr, bool copyValue = true);
@@ -120,6 +146,14 @@ class Compiler {
   Ref<TypeAnnotation> resolveVariableRelativeToModule(const std::string& name, bool set = false, bool checkIsConst = false);
   TypeInfo getModuleInfo(const std::vector<std::string>& modules);
 
+  bool isBorrowingMethod(Ref<TypeAnnotation> receiverType, const std::string& name) const;
+
+  /* Shape of the class of value of node (with type), nullptr if it's unknown
+   * Known for values annotated with a class declared in this file, and for self in methods of such class.
+   * It's only a hint: OP_GET_SLOT and OP_SET_SLOT check the class of the instance at runtime.
+   */
+  const ClassShape* getReceiverShape(ast::Node* node, Ref<TypeAnnotation> type);
+
   std::vector<Function::Argument> parseArgs(ast::VarDeclList* args);
   void defineArgs(ast::VarDeclList* args);
 
@@ -140,7 +174,7 @@ class Compiler {
   Ref<TypeAnnotation> cast(ast::Node* node, bool copyValue = true);
   Ref<TypeAnnotation> ref(ast::Node* node);
   Ref<TypeAnnotation> newexpr(ast::Node* node);
-  Ref<TypeAnnotation> call(ast::Node* node, bool topLevelCallee = false, TypeInfo typeInfo = {TypeAnnotation::any(), nullptr}, bool explicitSelf = false);
+  Ref<TypeAnnotation> call(ast::Node* node, bool topLevelCallee = false, TypeInfo typeInfo = {TypeAnnotation::any(), nullptr, nullptr}, bool explicitSelf = false, bool isTailCall = false);
   Ref<TypeAnnotation> callMember(const std::string& memberName, const std::vector<ast::Node*>& args, bool isReturnValueExpected, bool explicitSelf, Ref<TypeAnnotation> type);
   Ref<TypeAnnotation> lambda(ast::Node* node);
   Ref<TypeAnnotation> dict(ast::Node* node);
@@ -160,6 +194,19 @@ class Compiler {
 
 Compiler::ModuleInfo loadModule(const std::string& name, const std::string& filename, const std::string& parentModule);
 Compiler::ModuleInfo loadNativeModule(const std::string& name, const std::string& filename);
+
+/* Module registry of the isolate (see ff/isolate.h)
+ * Each file (by canonical path) is loaded once per isolate, later imports of it share the same Module.
+ */
+Compiler::ModuleInfo importModule(const std::string& name, const std::string& filename, const std::string& parentModule);
+std::string resolveImport(const std::string& import, const std::vector<std::string>& paths); // Cached path::getImportFileFromPath
+
+/* Import graph of a parsed file is discovered up front, modules in it are read, scanned and parsed
+ * on a thread pool (config 'import_threads' threads), while the importer compiles and initializes them
+ * in dependency order as it reaches their imports. Compilation itself stays on the importing thread.
+ */
+void prefetchImports(const std::string& filename, ast::Node* tree);
+bool takePrefetchedModule(const std::string& filename, std::string& src, ast::Node*& tree); // Waits for the parse, rethrows its errors
 Ref<Code> compile(const std::string& src, const std::string& filename = "<input>");
 
 } /* namespace ff */
@@ -7,7 +7,7 @@
 
 namespace ff {
 
-struct TypeAnnotation {
+struct TypeAnnotation : public RefCounted {
   enum Type {
     TATYPE_DEFAULT,
     TATYPE_FUNCTION,
@@ -3,6 +3,7 @@
 
 #include <ff/ref.h>
 #include <ff/object.h>
+#include <ff/value.h>
 #include <ff/types.h>
 #include <ff/module.h>
 #include <ff/runtime.h>
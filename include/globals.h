@@ -0,0 +1,26 @@
+#ifndef _FF_GLOBALS_H_
+#define _FF_GLOBALS_H_ 1
+
+#include <cstdint>
+#include <string>
+
+namespace ff {
+
+/* Process-wide table of global variable slots
+ * Compiler resolves global names to slots, OP_*_GLOBAL operands index the code's table of slots
+ * (Code::getGlobals), so bytecode itself doesn't depend on the order slots were assigned in.
+ * Table is shared between all compilers and VMs, so code of imported modules (compiled by
+ * a separate compiler and run in a separate VM) uses the same slot for the same name.
+ * Slots are shared by isolates too (values are per VM), the table is guarded by a lock.
+ */
+namespace globals {
+
+uint32_t getSlot(const std::string& name);
+bool findSlot(const std::string& name, uint32_t& slot);
+const std::string& getName(uint32_t slot);
+uint32_t count();
+
+} /* namespace globals */
+} /* namespace ff */
+
+#endif /* _FF_GLOBALS_H_ */
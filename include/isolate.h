@@ -0,0 +1,28 @@
+#ifndef _FF_ISOLATE_H_
+#define _FF_ISOLATE_H_ 1
+
+#include <ff/compiler/type_annotation.h>
+#include <ff/object.h>
+#include <ff/ref.h>
+
+namespace ff {
+
+/* Isolates
+ * Every thread that compiles or runs code is an isolate: objects it creates (instances, classes, modules,
+ * compiled code, inline caches) belong to it and are never passed to another thread.
+ * Its VMs, imported modules (see importModule) and memory pools (see memory::pool) are per thread as well.
+ * The only objects shared between isolates are immortal ones, which are read-only after they are made immortal:
+ *   - built-in types with their methods, builtin functions and the any/nothing/type annotations, built by initialize()
+ *   - symbols of native modules, made immortal when the library is loaded for the first time
+ * Reference counts of immortal objects are never modified (see RefCounted), so counts stay non-atomic.
+ * Process-wide tables (config, global slots, symbols, loaded libraries, module cache files) are guarded by locks.
+ */
+
+void initialize(); // Builds shared objects, must be called once before any isolate is started
+
+void makeImmortal(Ref<Object> object);                 // Marks object and everything reachable from it
+void makeImmortal(Ref<TypeAnnotation> annotation);
+
+} /* namespace ff */
+
+#endif /* _FF_ISOLATE_H_ */
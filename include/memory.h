@@ -2,6 +2,7 @@
 #define _FF_MEMORY_H_ 1
 
 #include <cstdlib>
+#include <cstddef>
 #include <ff/ref.h>
 
 #ifdef _FF_MEMORY_DEBUG
@@ -11,6 +12,35 @@
 
 namespace ff {
 namespace memory {
+
+/* Size-class slab allocator, used by memory::raw when built with _FF_POOL_ALLOCATOR
+ * Blocks are carved from aligned chunks, every chunk serves a single size class,
+ * so a block's size class is found from its address and free doesn't need the size.
+ */
+namespace pool {
+
+constexpr size_t kGranularity = 16;
+constexpr size_t kSizeClassCount = 16;
+constexpr size_t kMaxBlockSize = kGranularity * kSizeClassCount;
+
+void* allocate(size_t size);
+void* reallocate(void* ptr, size_t size);
+void free(void* ptr);
+
+#ifdef _FF_MEMORY_DEBUG
+struct SizeClassStats {
+  size_t blockSize; // 0 for allocations bigger than kMaxBlockSize
+  size_t live;
+  size_t peak;
+  size_t total;
+};
+
+SizeClassStats getStats(size_t sizeClass);
+void printStats();
+#endif
+
+} /* namespace pool */
+
 namespace raw {
 
 template <typename T>
@@ -19,7 +49,11 @@ inline void free(T* ptr) {
   std::cout << "memory::raw::free<" << mrt::getTypeName<T>() << ">(" << ptr << ")" << std::endl;
 #endif
   ptr->~T();
+#ifdef _FF_POOL_ALLOCATOR
+  pool::free(ptr);
+#else
   ::free(ptr);
+#endif
 }
 
 template <typename T>
@@ -33,7 +67,11 @@ inline T* reallocate(T* ptr, size_t count = 1) {
     return nullptr;
   }
 
+#ifdef _FF_POOL_ALLOCATOR
+  void* result = pool::reallocate((void*)ptr, count * sizeof(T));
+#else
   void* result = realloc((void*)ptr, count * sizeof(T));
+#endif
 
 #ifdef _FF_MEMORY_DEBUG
   if (!ptr) {
@@ -0,0 +1,29 @@
+#ifndef _FF_MODULE_CACHE_H_
+#define _FF_MODULE_CACHE_H_ 1
+
+#include <ff/bytecode.h>
+#include <string>
+
+namespace ff {
+
+/* On-disk compile cache for imported modules
+ * Every source file has one entry in config 'cache_dir' (named after a hash of its absolute path), which holds:
+ *   key:   magic "FFM\0", u64 cache version, absolute path, mtime, size, content hash,
+ *          import resolution context (cwd, FF_IMPORT_PATH, config 'import_path'),
+ *          files of directly imported modules with their mtime and size
+ *   image: bytecode::ModuleImage
+ * Entry is used when source mtime and size match, or when they don't but content hash does (file was touched).
+ * Any mismatch, including a changed import, makes loadModule compile the module again and replace the entry.
+ */
+namespace cache {
+
+bool isEnabled(); // Disabled when 'cache_dir' is empty or in debug mode (which dumps AST of every module)
+
+bool isValid(const std::string& filename); // Checks the key only, doesn't load anything
+bool load(const std::string& filename, bytecode::ModuleImage& module); // Returns false if there is no valid entry
+void store(const std::string& filename, const std::string& src, const bytecode::ModuleImage& module);
+
+} /* namespace cache */
+} /* namespace ff */
+
+#endif /* _FF_MODULE_CACHE_H_ */
@@ -3,8 +3,11 @@
 
 #include <cstdint>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <ff/ref.h>
+#include <ff/symbol.h>
+#include <ff/utils/copy_on_write.h>
 
 namespace ff {
 
@@ -15,10 +18,47 @@ enum ObjectType {
   OTYPE_TYPE,
 };
 
-class Object {
+using TypeId = uint32_t;
+
+/* Ids of built-in types, types created without an explicit id get one after TYPEID_BUILTIN_COUNT */
+enum BuiltinTypeId : TypeId {
+  TYPEID_NONE,
+  TYPEID_INT,
+  TYPEID_FLOAT,
+  TYPEID_BOOL,
+  TYPEID_STRING,
+  TYPEID_FUNCTION,
+  TYPEID_NATIVE_FUNCTION,
+  TYPEID_MODULE,
+  TYPEID_DICT,
+  TYPEID_VECTOR,
+  TYPEID_CLASS,
+  TYPEID_CLASS_INSTANCE,
+  TYPEID_CPTR,
+  TYPEID_BUILTIN_COUNT,
+};
+
+/* Header is kept small, because every value (including every int, float and bool) is an Object:
+ * vtable, reference count, object type and a single pointer to fields, which most values never have
+ */
+class Object : public RefCounted {
+ public:
+  using FieldsType = std::unordered_map<Symbol, Ref<Object>, Symbol::Hash>; // Unordered, see getSortedFields
+
  private:
+  /* Allocated when fields are modified for the first time, shared by copies (see CopyOnWrite) */
+  struct FieldTable {
+    FieldsType fields;
+    uint64_t version;
+
+    FieldTable();
+    FieldTable(const FieldTable& other); // Copy gets a new version
+
+    bool empty() const;
+  };
+
   ObjectType m_type;
-  std::map<std::string, Ref<Object>> m_fields;
+  CopyOnWrite<FieldTable> m_fields;
 
  public:
   explicit Object(ObjectType type);
@@ -28,11 +68,21 @@ class Object {
   bool isInstance() const;
   bool isType() const;
 
-  bool hasField(const std::string& key) const;
-  Ref<Object> getField(const std::string& key);
-  void setField(const std::string& key, Ref<Object> value);
-  std::map<std::string, Ref<Object>>& getFields();
-  const std::map<std::string, Ref<Object>>& getFields() const;
+  virtual bool hasField(const Symbol& key) const;
+  virtual Ref<Object> getField(const Symbol& key);
+  virtual void setField(const Symbol& key, Ref<Object> value);
+  FieldsType& getFields(); // Duplicates fields shared with a copy, use const overload to only read them
+  const FieldsType& getFields() const;
+  std::vector<std::pair<Symbol, Ref<Object>>> getSortedFields() const; // Ordered by name, for output
+
+  /* Replaces fields with fields of other, storage is shared until either of them is modified */
+  void shareFields(const Object& other);
+  void makeFieldsImmortal() const;
+
+  /* Changes every time fields may have been modified (used by inline caches)
+   * Unique across all objects, except for objects that share the same fields, or that have no fields
+   */
+  uint64_t getFieldsVersion() const;
 
   virtual std::string toString() const;
   virtual bool equals(Ref<Object> other) const;
@@ -44,25 +94,29 @@ class Object {
 class Type : public Object {
  private:
   std::string m_typeName;
+  TypeId m_typeId;
 
  public:
   explicit Type(const std::string& typeName);
+  Type(const std::string& typeName, TypeId typeId);
   virtual ~Type() = default;
 
-  std::string getTypeName() const;
+  const std::string& getTypeName() const;
+  TypeId getTypeId() const;
 
   bool equals(Ref<Object> other) const override;
 };
 
 class Instance : public Object {
  private:
-  Ref<Type> m_type;
+  Type* m_type; // Types live until the process exits (see ff/isolate.h), so instances don't own them
 
  public:
   explicit Instance(Ref<Type> type);
   virtual ~Instance() = default;
 
   Ref<Type> getType() const;
+  TypeId getTypeId() const;
 };
 
 } /* namespace ff */
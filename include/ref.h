@@ -16,62 +16,105 @@ namespace memory::raw {
 template <typename T> inline void free(T* ptr);
 } /* namespace memory::raw */
 
+/* Base for everything that is managed by Ref<T>
+ * Reference count is stored in the object itself (intrusive), so Ref<T> is a single pointer
+ * Copying an object doesn't copy its reference count
+ * Immortal objects (see ff/isolate.h) are never freed and their count is never modified again,
+ * so they can be shared by threads while counts stay plain integers
+ */
+class RefCounted {
+ public:
+  using SizeType = size_t;
+
+  static constexpr SizeType kImmortalBit = (SizeType)1 << (sizeof(SizeType) * 8 - 1);
+
+ private:
+  mutable SizeType m_refCount = 0;
+
+ public:
+  inline RefCounted() = default;
+  inline RefCounted(const RefCounted&) {}
+  inline ~RefCounted() = default;
+
+  inline RefCounted& operator=(const RefCounted&) {
+    return *this;
+  }
+
+  inline SizeType getRefCount() const {
+    return m_refCount & ~kImmortalBit;
+  }
+
+  inline bool isImmortal() const {
+    return m_refCount & kImmortalBit;
+  }
+
+  inline void makeImmortal() const {
+    m_refCount |= kImmortalBit;
+  }
+
+  template <typename>
+  friend class Ref;
+};
+
 template <typename T>
 class Ref {
  public:
-  using SizeType = size_t; 
+  using SizeType = RefCounted::SizeType;
 
  private:
   T* m_data = nullptr;
-  SizeType* m_count = nullptr;
 
  public:
   inline Ref() {}
 
-  inline explicit Ref(T* ptr) : m_data(ptr), m_count(new SizeType{0}) {
+  inline explicit Ref(T* ptr) : m_data(ptr) {
 #ifdef _FF_REF_DEBUG
-    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ") ptr (count " << m_count << ")\n";
+    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ") ptr\n";
 #endif
-    (*m_count)++;
+    retain();
   }
 
-  inline Ref(const Ref& rhs) {
-    *this = rhs;
+  inline Ref(const Ref& rhs) : m_data(rhs.m_data) {
+    retain();
+#ifdef _FF_REF_DEBUG
+    std::cout << "Ref<" << mrt::getTypeName<T>() <<  ">(" << m_data << ") copy (count=" << (int)count() << ")\n";
+#endif
   }
 
-  inline Ref(Ref&& rhs) {
-    *this = rhs;
+  inline Ref(Ref&& rhs) noexcept : m_data(rhs.m_data) {
+    rhs.m_data = nullptr;
+#ifdef _FF_REF_DEBUG
+    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ") move (count=" << (int)count() << ")\n";
+#endif
   }
 
   inline Ref& operator=(T* ptr) {
+    if (ptr && !ptr->isImmortal()) {
+      ptr->m_refCount++;
+    }
     cleanup();
     m_data = ptr;
-    m_count = new SizeType;
-    (*m_count)++;
     return *this;
   }
 
   inline Ref& operator=(const Ref& rhs) {
+    rhs.retain();
     cleanup();
-    if (rhs.m_data) {
-      m_data = rhs.m_data;
-      m_count = rhs.m_count;
-      (*m_count)++;
-    }
+    m_data = rhs.m_data;
 #ifdef _FF_REF_DEBUG
-    std::cout << "Ref<" << mrt::getTypeName<T>() <<  ">(" << m_data << ") copy (count=" << (int)(m_count ? *m_count : -1) << ")\n";
+    std::cout << "Ref<" << mrt::getTypeName<T>() <<  ">(" << m_data << ") copy (count=" << (int)count() << ")\n";
 #endif
     return *this;
   }
 
-  inline Ref& operator=(Ref&& rhs) {
-    cleanup();
-    m_data = rhs.m_data;
-    m_count = rhs.m_count;
-    rhs.m_data = nullptr;
-    rhs.m_count = nullptr;
+  inline Ref& operator=(Ref&& rhs) noexcept {
+    if (this != &rhs) {
+      cleanup();
+      m_data = rhs.m_data;
+      rhs.m_data = nullptr;
+    }
 #ifdef _FF_REF_DEBUG
-    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ") move (&count=" << m_count << ", count=" << (int)(m_count ? *m_count : -1) << ")\n";
+    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ") move (count=" << (int)count() << ")\n";
 #endif
     return *this;
   }
@@ -106,19 +149,15 @@ class Ref {
   }
 
   template <typename R>
-  inline Ref<R> asRefTo() {
+  inline Ref<R> asRefTo() const {
 #ifdef _FF_REF_DEBUG
-    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::asRefTo<" << mrt::getTypeName<R>() << ">() &count=" << m_count <<  " count=" << (int)(m_count ? *m_count : -1) << "\n";
+    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::asRefTo<" << mrt::getTypeName<R>() << ">() count=" << (int)count() << "\n";
 #endif
-    Ref<R> ref;
-    ref.m_count = m_count;
-    ref.m_data = (R*)m_data;
-    (*m_count)++;
-    return ref;
+    return Ref<R>((R*)m_data);
   }
 
   inline SizeType count() const {
-    return *m_count;
+    return m_data ? m_data->getRefCount() : 0;
   }
 
   inline void reset() {
@@ -130,23 +169,27 @@ class Ref {
   }
 
  private:
-  void cleanup() {
-#ifdef _FF_REF_DEBUG
-    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::cleanup() &count=" << m_count <<  "\n";
-#endif
-    if (m_data && m_count) {
-      (*m_count)--;
-      if (*m_count == 0) {
+  inline void retain() const {
+    if (m_data && !m_data->isImmortal()) {
+      m_data->m_refCount++;
+    }
+  }
+
+  inline void cleanup() {
 #ifdef _FF_REF_DEBUG
-        std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::cleanup() delete count=" << m_count <<  "\n";
+    std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::cleanup() count=" << (int)count() << "\n";
 #endif
-        delete m_count;
+    if (m_data) {
+      T* data = m_data;
+      m_data = nullptr;
+      SizeType count = data->m_refCount;
+      if (count == 1) {
 #ifdef _FF_REF_DEBUG
-        std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << m_data << ")::cleanup() delete\n";
+        std::cout << "Ref<" << mrt::getTypeName<T>() << ">(" << data << ")::cleanup() delete\n";
 #endif
-        memory::raw::free(m_data);
-        m_data = nullptr;
-        m_count = nullptr;
+        memory::raw::free(data);
+      } else if (!(count & RefCounted::kImmortalBit)) {
+        data->m_refCount = count - 1;
       }
     }
   }
@@ -158,4 +201,7 @@ class Ref {
 
 } /* namespace ff */
 
-#endif /* _FF_REF_H_ */
\ No newline at end of file
+// memory::raw::free must be visible wherever Ref<T> is instantiated
+#include <ff/memory.h>
+
+#endif /* _FF_REF_H_ */
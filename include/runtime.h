@@ -4,8 +4,11 @@
 #include <ff/errors.h>
 #include <ff/object.h>
 #include <ff/types.h>
+#include <ff/value.h>
 #include <ff/stack.h>
 #include <ff/code.h>
+#include <ff/globals.h>
+#include <ff/symbol.h>
 #include <ff/ref.h>
 #include <cstdarg>
 #include <string>
@@ -15,16 +18,27 @@ namespace ff {
 
 class VM {
  public:
-  using StackType = Ref<Object>;
+  using StackType = Value;
 
+  /* Frame of a running function
+   * Frame's values live on the shared VM stack starting at `base`,
+   * first of them are the arguments (the last argument is at `base`)
+   */
   struct CallFrame {
-    Function::Context context;
+    Ref<Code> code;
+    size_t codeOffset = 0;
+    size_t base = 0;
+  };
+
+  struct Global {
+    Ref<Object> value;
+    bool isDefined = false;
   };
 
  private:
+  Stack<StackType> m_stack;
   Stack<CallFrame> m_callStack;
-  std::map<std::string, Ref<Object>> m_globals;
-  bool m_running = false;
+  std::vector<Global> m_globals; // Indexed by slot from globals::getSlot
   bool m_requestStop = false;
   int m_returnCode = 0;
 
@@ -39,29 +53,38 @@ class VM {
   int getReturnCode();
   void setReturnCode(int returnCode);
 
+  static size_t getCopyCount(); // __copy__ calls made by OP_COPY on this thread, printed with config 'copy_stats'
+
   Stack<StackType>& getStack();
-  std::map<std::string, Ref<Object>>& getGlobals();
+  std::map<std::string, Ref<Object>> getGlobals();
+  bool hasGlobal(const std::string& name);
+  Ref<Object> getGlobal(const std::string& name);
+  void setGlobal(const std::string& name, Ref<Object> value);
 
-  void push(Ref<Object> obj);
-  Ref<Object> pop();
-  std::vector<Ref<Object>> pop(int count, bool reverse = false);
-  std::vector<Ref<Object>> popFrom(int frameOffset, int count);
+  void push(Value value);
+  Value pop();
+  std::vector<Value> pop(int count, bool reverse = false);
 
   void jumpForward(uint32_t offset);
   void jump(uint32_t offset);
 
+  /* Calls below return after the callee has finished (its result is on top of the stack),
+   * so they can be used by native functions to call back into ff code
+   */
   void call(const std::string& functionName);
 
   void call(Ref<Object> object, int argc = 0);
   void call(Ref<Object> object, const std::vector<Ref<Object>>& args);
-  void callMember(Ref<Object> self, const std::string& memberName, int argc = 0);
-  void callMember(Ref<Object> self, const std::string& memberName, std::vector<Ref<Object>> args);
-  void callFunction(Ref<Function> fn, const std::vector<Ref<Object>>& args);
+  void callMember(Ref<Object> self, const Symbol& memberName, int argc = 0);
+  void callMember(Ref<Object> self, const Symbol& memberName, std::vector<Ref<Object>> args);
+  Ref<Object> findMember(const Ref<Object>& self, const Symbol& memberName, bool& implicitSelf, InlineCache::Entry* entry = nullptr);
+  /* Arguments are expected on top of the stack, they become the first locals of the function's frame */
+  void callFunction(Ref<Function> fn, int argc);
   void callNativeFunction(Ref<NativeFunction> fn, const std::vector<Ref<Object>>& args);
 
   template <typename T>
   inline Ref<Object> popCheckType(Ref<T> type) {
-    Ref<Object> value = pop();
+    Ref<Object> value = pop().box();
     checkType(value, type);
     return value;
   }
@@ -79,15 +102,35 @@ class VM {
 
   CallFrame& currentFrame();
   Ref<Code>& getCode();
+  Global& getGlobalSlot(uint32_t slot);
+  /* Call helpers used by the dispatch loop
+   * With nested=false an ff function only gets its frame pushed, and the dispatch loop continues in it.
+   * With nested=true the function is run to completion (by a nested dispatch loop) before returning.
+   */
+  void callObject(const Ref<Object>& object, int argc, bool nested);
+  void callFoundMember(const Ref<Object>& self, const Symbol& memberName, const Ref<Object>& fnObject, bool implicitSelf, int argc, bool nested);
+  /* Field access helpers used by the dispatch loop when cache misses, lookup is recorded in cache
+   * Slot of a class instance field is recorded only if it's expectedSlot (InlineCache::kNoSlot accepts any slot)
+   */
+  Ref<Object> getField(const Ref<Object>& object, const Symbol& name, InlineCache& cache, uint32_t expectedSlot);
+  void setField(const Ref<Object>& object, const Symbol& name, Ref<Object> value, InlineCache& cache, uint32_t expectedSlot);
+  void callMemberArgs(const Ref<Object>& self, const Symbol& memberName, const std::vector<Ref<Object>>& args, bool nested);
+  void invokeFunction(const Ref<Function>& fn, int argc, bool nested);
+  void callNative(const Ref<NativeFunction>& fn, int argc);
 
   RuntimeError createError(const std::string& msg);
   RuntimeError createError(const char* fmt, ...);
 
   void run();
-  bool executeInstruction(Opcode op);
-
-  void runCode(Ref<Code> code, std::vector<Ref<Object>> args = {});
-  Ref<Object> returnCall();
+  bool isTruthy(const Value& value);
+  bool toBool(const Value& value);
+  int popArgc();
+  bool binaryOp(Opcode op, const Value& lhs, const Value& rhs);
+
+  void runCode(Ref<Code> code, int argc = 0);
+  void enterCode(Ref<Code> code, int argc);
+  void replaceFrame(Ref<Code> code, int argc);
+  Value returnCall();
 
   void runtimeBreakpoint();
   void printStack();
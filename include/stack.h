@@ -6,6 +6,7 @@
 #include <exception>
 #include <vector>
 #include <cstddef>
+#include <utility>
 
 namespace ff {
 
@@ -23,57 +24,96 @@ class StackUnderflowException : public std::exception {
   const char* what() const noexcept override;
 };
 
+/* LIFO container
+ * Default constructed stack grows as needed. Stack constructed with a capacity
+ * preallocates all of its slots and throws StackOverflowException instead of growing,
+ * so references to its elements stay valid for as long as they are on the stack.
+ */
 template <typename T>
 class Stack {
  private:
   std::vector<T> m_data;
+  size_t m_size = 0;
+  bool m_isFixed = false;
 
  public:
-  inline Stack() {
-    reset();
-  }
+  inline Stack() {}
+
+  inline explicit Stack(size_t capacity) : m_data(capacity), m_isFixed(true) {}
 
   inline ~Stack() {}
 
   inline void reset() {
-    // m_stackTop = m_stack;
-    m_data.clear();
+    truncate(0);
   }
 
   inline size_t size() const {
+    return m_size;
+  }
+
+  inline size_t capacity() const {
     return m_data.size();
   }
 
   inline bool canPop() const {
-    return m_data.size() > 0;
+    return m_size > 0;
   }
 
-  inline void push(T value) {
-    m_data.push_back(value);
+  inline void push(const T& value) {
+    reserveOne();
+    m_data[m_size++] = value;
+  }
+
+  inline void push(T&& value) {
+    reserveOne();
+    m_data[m_size++] = std::move(value);
   }
 
   inline T pop() {
     if (!canPop()) {
       throw StackUnderflowException();
     }
-    T object = m_data.back();
-    m_data.pop_back();
-    return object;
+    return std::move(m_data[--m_size]);
+  }
+
+  /* Pops (and releases) elements until size is equal to `size` */
+  inline void truncate(size_t size) {
+    while (m_size > size) {
+      m_data[--m_size] = T();
+    }
+  }
+
+  /* Removes element at `index`, shifting the ones above it down */
+  inline void erase(size_t index) {
+    for (size_t i = index; i + 1 < m_size; i++) {
+      m_data[i] = std::move(m_data[i + 1]);
+    }
+    m_data[--m_size] = T();
   }
 
   inline T& peek(int distance = 0) {
-    return m_data[m_data.size()-1-distance];
+    return m_data[m_size-1-distance];
   }
 
-  inline T& operator [](unsigned index) {
+  inline T& operator [](size_t index) {
     return m_data[index];
   }
 
-  inline std::vector<T>& getBuffer() {
-    return m_data;
+  inline T* data() {
+    return m_data.data();
+  }
+
+ private:
+  inline void reserveOne() {
+    if (m_size == m_data.size()) {
+      if (m_isFixed) {
+        throw StackOverflowException();
+      }
+      m_data.resize(m_data.empty() ? 16 : m_data.size() * 2);
+    }
   }
 };
 
 } /* namespace ff */
 
-#endif /* _FF_STACK_H_ */
\ No newline at end of file
+#endif /* _FF_STACK_H_ */
@@ -0,0 +1,72 @@
+#ifndef _FF_SYMBOL_H_
+#define _FF_SYMBOL_H_ 1
+
+#include <cstddef>
+#include <string>
+
+namespace ff {
+
+/* Interned name of a field, method or global
+ * Every distinct name is stored once for the lifetime of the process, so symbols are compared by pointer
+ * and hashed with the hash computed when the name was interned. Object fields are keyed by symbols.
+ * Table is process-wide (shared by isolates), interning takes a lock, using a symbol doesn't.
+ * Symbols are implicitly made from strings, which interns them, so code on a hot path should make
+ * its symbols once (compiled code does that for every name it uses, see Code::addSymbol).
+ */
+class Symbol {
+ private:
+  struct Entry {
+    std::string name;
+    size_t hash;
+  };
+
+  struct Table;
+
+  const Entry* m_entry;
+
+ public:
+  struct Hash {
+    inline size_t operator()(const Symbol& symbol) const noexcept {
+      return symbol.hash();
+    }
+  };
+
+ public:
+  Symbol(); // Empty name
+  Symbol(const std::string& name);
+  Symbol(const char* name);
+
+  inline const std::string& str() const {
+    return m_entry->name;
+  }
+
+  inline const char* c_str() const {
+    return m_entry->name.c_str();
+  }
+
+  inline size_t hash() const {
+    return m_entry->hash;
+  }
+
+  inline bool operator==(const Symbol& rhs) const {
+    return m_entry == rhs.m_entry;
+  }
+
+  inline bool operator!=(const Symbol& rhs) const {
+    return m_entry != rhs.m_entry;
+  }
+
+  bool operator<(const Symbol& rhs) const; // Orders by name
+
+  static bool find(const std::string& name, Symbol& symbol); // Doesn't intern name, false if it never was
+
+ private:
+  explicit Symbol(const Entry* entry);
+
+  static Table& getTable();
+  static const Entry* intern(const std::string& name);
+};
+
+} /* namespace ff */
+
+#endif /* _FF_SYMBOL_H_ */
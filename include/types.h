@@ -28,7 +28,7 @@ inline bool isOfType(Ref<O> object, Ref<T> type) {
   if (!object->isInstance()) {
     throw RuntimeError::create("Expected an object");
   }
-  return object.template as<Instance>()->getType()->getTypeName() == type.template asRefTo<Type>()->getTypeName();
+  return object.template as<Instance>()->getTypeId() == type.template as<Type>()->getTypeId();
 }
 
 template <typename O>
@@ -60,6 +60,7 @@ Ref<Bool> boolean(Ref<Object> object);
 Ref<Function> fn(Function::ValueType code, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
 Ref<Function> fn(Ref<Object> object);
 Ref<NativeFunction> fn(NativeFunction::ValueType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
+Ref<NativeFunction> fn(NativeFunction::FastType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
 Ref<NativeFunction> nativefn(Ref<Object> object);
 Ref<Module> module(const std::string& name);
 Ref<Module> module(Ref<Object> object);
@@ -5,6 +5,7 @@
 #include <ff/object.h>
 #include <ff/ref.h>
 #include <unordered_map>
+#include <vector>
 
 namespace ff {
 
@@ -25,19 +26,32 @@ class ClassType : public Type {
 class Class : public Instance {
  public:
   struct Field {
-    std::string name;
+    Symbol name;
     bool isStatic = false;
     Ref<Object> initialValue;
   };
 
+  /* Layout of instance fields: slot of every non-static field, in the order fields were added
+   * Fields are only ever appended, so a slot stays valid for the lifetime of the class.
+   */
+  struct Shape {
+    std::vector<Symbol> names;                        // Indexed by slot
+    std::unordered_map<Symbol, uint32_t, Symbol::Hash> slots;
+    std::vector<Ref<Object>> initialValues;           // Indexed by slot, copied into every new instance
+  };
+
   std::string className;
-  std::unordered_map<std::string, Field> fieldInfo;
+  std::unordered_map<Symbol, Field, Symbol::Hash> fieldInfo;
+  Shape shape;
 
  public:
   explicit Class(const std::string& className);
   explicit Class(const std::string& className, const std::unordered_map<std::string, Field>& fieldInfo, const std::unordered_map<std::string, Ref<Object>>& methods);
   ~Class();
 
+  void addField(const Field& field); // Field that already exists keeps its slot, only initial value is replaced
+  int findSlot(const Symbol& name) const; // -1 if there is no such field in the shape
+
   std::string toString() const override;
   bool equals(Ref<Object> other) const override;
 
@@ -59,15 +73,36 @@ class ClassInstanceType : public Type {
   static Ref<ClassInstanceType> getInstance();
 };
 
+/* Fields of the class shape are stored in slots, so they are accessed by index (see OP_GET_SLOT)
+ * Fields that aren't in the shape of the class (set on the instance, or added to the class after the instance
+ * was created) are stored as ordinary object fields. hasField/getField/setField look in both.
+ */
 class ClassInstance : public Instance {
  private:
   Ref<Class> m_class;
+  std::vector<Ref<Object>> m_slots;
 
  public:
   explicit ClassInstance(Ref<Class> class_);
   ~ClassInstance();
 
-  Ref<Class> getClass() const;
+  const Ref<Class>& getClass() const;
+
+  inline size_t getSlotCount() const {
+    return m_slots.size();
+  }
+
+  inline const Ref<Object>& getSlot(uint32_t slot) const {
+    return m_slots[slot];
+  }
+
+  inline void setSlot(uint32_t slot, Ref<Object> value) {
+    m_slots[slot] = std::move(value);
+  }
+
+  bool hasField(const Symbol& key) const override;
+  Ref<Object> getField(const Symbol& key) override;
+  void setField(const Symbol& key, Ref<Object> value) override;
 
   std::string toString() const override;
   bool equals(Ref<Object> other) const override;
@@ -4,7 +4,6 @@
 #include <ff/object.h>
 #include <ff/ref.h>
 #include <string>
-#include <map>
 
 namespace ff {
 
@@ -24,7 +23,7 @@ class DictType : public Type {
 
 class Dict : public Instance {
  public:
-  using ValueType = std::map<std::string, Ref<Object>>;
+  using ValueType = Object::FieldsType; // Elements are stored as fields, so keys are symbols
 
  public:
   explicit Dict(ValueType value);
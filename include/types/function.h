@@ -3,7 +3,7 @@
 
 #include <ff/compiler/type_annotation.h>
 #include <ff/object.h>
-#include <ff/stack.h>
+#include <ff/value.h>
 #include <ff/code.h>
 #include <ff/ref.h>
 #include <string>
@@ -33,12 +33,6 @@ class Function : public Instance {
     Ref<TypeAnnotation> type;
   };
 
-  struct Context {
-    Stack<Ref<Object>> stack;
-    size_t codeOffset;
-    Ref<Code> code;
-  };
-
   ValueType code;
   std::vector<Argument> args;
   Ref<TypeAnnotation> returnType = TypeAnnotation::create("any");
@@ -4,8 +4,10 @@
 #include <ff/object.h>
 #include <ff/types/function.h>
 #include <ff/compiler/type_annotation.h>
+#include <ff/value.h>
 #include <ff/ref.h>
 #include <functional>
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -13,6 +15,27 @@ namespace ff {
 
 class VM;
 
+/* Arguments of a native function call
+ * Points directly into the VM stack, where arguments lay last to first
+ * (values are boxed in place by the VM before the call)
+ */
+class NativeArgs {
+ private:
+  const Value* m_end;
+  size_t m_size;
+
+ public:
+  inline NativeArgs(const Value* end, size_t size) : m_end(end), m_size(size) {}
+
+  inline const Ref<Object>& operator[](size_t index) const {
+    return m_end[-1 - (ptrdiff_t)index].asObject();
+  }
+
+  inline size_t size() const {
+    return m_size;
+  }
+};
+
 class NativeFunctionType : public Type {
  private:
   static Ref<NativeFunctionType> m_instance;
@@ -30,13 +53,17 @@ class NativeFunctionType : public Type {
 class NativeFunction : public Instance {
  public:
   using ValueType = std::function<Ref<Object>(VM*, std::vector<Ref<Object>>)>; // result (context, args)
+  using FastType = Ref<Object>(*)(VM*, NativeArgs);                           // result (context, args)
 
-  ValueType func;
+  ValueType func;     // Used if fastFunc is null, can hold closures
+  FastType fastFunc = nullptr;
   std::vector<Function::Argument> args;
   Ref<TypeAnnotation> returnType;
+  bool borrowsArgs = false; // Arguments are only read during the call, so the compiler doesn't copy them (see Compiler::evalNode)
 
  public:
   NativeFunction(ValueType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
+  NativeFunction(FastType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
   ~NativeFunction();
 
   std::vector<Function::Argument>& getArgs();
@@ -46,6 +73,7 @@ class NativeFunction : public Instance {
   bool equals(Ref<Object> other) const override;
 
   static Ref<NativeFunction> createInstance(ValueType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
+  static Ref<NativeFunction> createInstance(FastType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType);
 };
 
 } /* namespace ff */
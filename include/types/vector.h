@@ -3,6 +3,7 @@
 
 #include <ff/object.h>
 #include <ff/ref.h>
+#include <ff/utils/copy_on_write.h>
 #include <string>
 #include <vector>
 
@@ -26,10 +27,11 @@ class Vector : public Instance {
  public:
   using ValueType = std::vector<Ref<Object>>;
 
-  ValueType value;
+  CopyOnWrite<ValueType> value; // Shared with copies of the vector until either of them is modified
 
  public:
   explicit Vector(const ValueType& value);
+  explicit Vector(const CopyOnWrite<ValueType>& value);
   ~Vector();
 
   std::string toString() const override;
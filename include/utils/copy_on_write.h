@@ -0,0 +1,67 @@
+#ifndef _FF_UTILS_COPY_ON_WRITE_H_
+#define _FF_UTILS_COPY_ON_WRITE_H_ 1
+
+#include <ff/memory.h>
+#include <ff/ref.h>
+
+namespace ff {
+
+/* Value stored in a refcounted buffer that is shared by copies until one of them is modified
+ * Copying only retains the buffer, getMutable() duplicates it first if anyone else holds it.
+ * Buffer is allocated on first modification, so an empty value is a single null pointer.
+ * Immortal buffers (see ff/isolate.h) are shared by isolates, they are duplicated before every modification.
+ */
+template <typename T>
+class CopyOnWrite {
+ private:
+  struct Buffer : public RefCounted {
+    T value;
+
+    Buffer() = default;
+    explicit Buffer(const T& value) : value(value) {}
+  };
+
+  Ref<Buffer> m_buffer;
+
+ public:
+  CopyOnWrite() = default;
+
+  explicit CopyOnWrite(const T& value) {
+    if (!value.empty()) {
+      m_buffer = memory::construct<Buffer>(value);
+    }
+  }
+
+  inline const T& get() const {
+    return m_buffer.get() ? m_buffer->value : empty();
+  }
+
+  inline T& getMutable() {
+    if (!m_buffer.get()) {
+      m_buffer = memory::construct<Buffer>();
+    } else if (m_buffer->getRefCount() > 1 || m_buffer->isImmortal()) {
+      m_buffer = memory::construct<Buffer>(m_buffer->value);
+    }
+    return m_buffer->value;
+  }
+
+  inline bool isShared() const {
+    return m_buffer.get() && (m_buffer->getRefCount() > 1 || m_buffer->isImmortal());
+  }
+
+  inline void makeImmortal() const {
+    if (m_buffer.get()) {
+      m_buffer->makeImmortal();
+    }
+  }
+
+ private:
+  static const T& empty() {
+    static const T value;
+    return value;
+  }
+};
+
+} /* namespace ff */
+
+#endif /* _FF_UTILS_COPY_ON_WRITE_H_ */
@@ -2,8 +2,9 @@
 #define _FF_UTILS_DYNAMIC_LIBRARY_MANAGER_H_ 1
 
 #include <mrt/dynamic_library.h>
-#include <ff/ref.h>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -11,7 +12,8 @@ namespace ff {
 
 class DynamicLibraryManager {
  private:
-  static std::unordered_map<std::string, Ref<mrt::DynamicLibrary>> m_libraries;
+  static std::unordered_map<std::string, std::shared_ptr<mrt::DynamicLibrary>> m_libraries;
+  static std::mutex m_mutex; // Libraries are loaded once for the process and shared by isolates
 
  private:
   DynamicLibraryManager() = default;
@@ -19,9 +21,9 @@ class DynamicLibraryManager {
  public:
   ~DynamicLibraryManager() = default;
 
-  static void setLibrary(const std::string& name, Ref<mrt::DynamicLibrary> library);
+  static void setLibrary(const std::string& name, std::shared_ptr<mrt::DynamicLibrary> library);
   static bool libraryExists(const std::string& name);
-  static Ref<mrt::DynamicLibrary> getLibrary(const std::string& name);
+  static std::shared_ptr<mrt::DynamicLibrary> getLibrary(const std::string& name);
   static void deleteLibrary(const std::string& name);
   static void clear();
 };
@@ -0,0 +1,33 @@
+#ifndef _FF_UTILS_MAPPED_FILE_H_
+#define _FF_UTILS_MAPPED_FILE_H_ 1
+
+#include <ff/ref.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace ff {
+
+/* Read-only memory mapping of a whole file
+ * Pages come from the page cache, so processes that map the same file share them.
+ * Mapping is released when the last Ref to it goes away.
+ */
+class MappedFile : public RefCounted {
+ private:
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+
+ public:
+  MappedFile(const uint8_t* data, size_t size);
+  MappedFile(const MappedFile&) = delete;
+  ~MappedFile();
+
+  const uint8_t* data() const;
+  size_t size() const;
+
+  static Ref<MappedFile> open(const std::string& filename); // Returns empty Ref on failure
+};
+
+} /* namespace ff */
+
+#endif /* _FF_UTILS_MAPPED_FILE_H_ */
@@ -12,12 +12,14 @@ bool exists(const std::string& path);
 std::string concat(std::string lhs, std::string rhs);
 std::string getcwd();
 std::string getFullPath(const std::string& path);
+std::string getCanonicalPath(const std::string& path); // Resolves symlinks, '.' and '..', returns full path if file doesn't exist
 std::string getFolder(std::string path);
 std::string getFile(std::string path);
 std::string stripExtension(std::string file);
 std::string getExtension(std::string path);
 std::string getImportFile(const std::string& file);
 std::string getImportFileFromPath(const std::string& file, std::vector<std::string> paths);
+bool createDirectories(const std::string& path);
 
 } /* namespace path */
 } /* namespace ff */
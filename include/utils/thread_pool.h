@@ -0,0 +1,38 @@
+#ifndef _FF_UTILS_THREAD_POOL_H_
+#define _FF_UTILS_THREAD_POOL_H_ 1
+
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+namespace ff {
+
+/* Fixed number of worker threads executing submitted jobs in FIFO order
+ * Jobs that haven't started when the pool is destroyed are dropped, running ones are waited for.
+ */
+class ThreadPool {
+ private:
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()>> m_jobs;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stop = false;
+
+ public:
+  explicit ThreadPool(size_t threadCount);
+  ThreadPool(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  void submit(std::function<void()> job);
+  size_t getThreadCount() const;
+
+ private:
+  void work();
+};
+
+} /* namespace ff */
+
+#endif /* _FF_UTILS_THREAD_POOL_H_ */
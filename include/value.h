@@ -0,0 +1,156 @@
+#ifndef _FF_VALUE_H_
+#define _FF_VALUE_H_ 1
+
+#include <ff/object.h>
+#include <ff/ref.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <new>
+
+namespace ff {
+
+/* Value that lives on the VM stack
+ * int, float and bool (and null) are stored inline, everything else is a Ref<Object>.
+ * Inline values are boxed into heap Int/Float/Bool only when they escape
+ * (globals, fields, containers, native function arguments).
+ */
+class Value {
+ public:
+  enum Tag : uint8_t {
+    VTAG_NULL,
+    VTAG_INT,
+    VTAG_FLOAT,
+    VTAG_BOOL,
+    VTAG_OBJECT,
+  };
+
+ private:
+  Tag m_tag = VTAG_NULL;
+  union {
+    int64_t m_int;
+    double m_float;
+    bool m_bool;
+    Ref<Object> m_object;
+  };
+
+ public:
+  inline Value() : m_int(0) {}
+
+  inline Value(Ref<Object> object) : m_int(0) {
+    if (object.get()) {
+      m_tag = VTAG_OBJECT;
+      new (&m_object) Ref<Object>(std::move(object));
+    }
+  }
+
+  inline Value(const Value& rhs) : m_int(0) {
+    copyFrom(rhs);
+  }
+
+  inline Value(Value&& rhs) noexcept : m_int(0) {
+    moveFrom(rhs);
+  }
+
+  inline ~Value() {
+    reset();
+  }
+
+  inline Value& operator=(const Value& rhs) {
+    if (this != &rhs) {
+      reset();
+      copyFrom(rhs);
+    }
+    return *this;
+  }
+
+  inline Value& operator=(Value&& rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      moveFrom(rhs);
+    }
+    return *this;
+  }
+
+  static inline Value fromInt(int64_t value) {
+    Value result;
+    result.m_tag = VTAG_INT;
+    result.m_int = value;
+    return result;
+  }
+
+  static inline Value fromFloat(double value) {
+    Value result;
+    result.m_tag = VTAG_FLOAT;
+    result.m_float = value;
+    return result;
+  }
+
+  static inline Value fromBool(bool value) {
+    Value result;
+    result.m_tag = VTAG_BOOL;
+    result.m_bool = value;
+    return result;
+  }
+
+  /* Copies value of int/float/bool object inline, other objects are kept as-is */
+  static Value unbox(const Ref<Object>& object);
+
+  inline Tag getTag() const { return m_tag; }
+  inline bool isNull() const { return m_tag == VTAG_NULL; }
+  inline bool isInt() const { return m_tag == VTAG_INT; }
+  inline bool isFloat() const { return m_tag == VTAG_FLOAT; }
+  inline bool isBool() const { return m_tag == VTAG_BOOL; }
+  inline bool isObject() const { return m_tag == VTAG_OBJECT; }
+  inline bool isInline() const { return m_tag == VTAG_INT || m_tag == VTAG_FLOAT || m_tag == VTAG_BOOL; }
+
+  inline int64_t asInt() const { return m_int; }
+  inline double asFloat() const { return m_float; }
+  inline bool asBool() const { return m_bool; }
+  inline const Ref<Object>& asObject() const { return m_object; }
+
+  /* Returns heap object for this value, allocates a new one for inline values */
+  Ref<Object> box() const;
+
+  /* Replaces inline value with a boxed one, so it can be shared (e.g. by `ref`) */
+  inline void boxInPlace() {
+    if (isInline()) {
+      *this = Value(box());
+    }
+  }
+
+  std::string toString() const;
+
+ private:
+  inline void reset() {
+    if (m_tag == VTAG_OBJECT) {
+      m_object.~Ref<Object>();
+    }
+    m_tag = VTAG_NULL;
+    m_int = 0;
+  }
+
+  inline void copyFrom(const Value& rhs) {
+    if (rhs.m_tag == VTAG_OBJECT) {
+      new (&m_object) Ref<Object>(rhs.m_object);
+    } else {
+      m_int = rhs.m_int;
+    }
+    m_tag = rhs.m_tag;
+  }
+
+  inline void moveFrom(Value& rhs) {
+    if (rhs.m_tag == VTAG_OBJECT) {
+      new (&m_object) Ref<Object>(std::move(rhs.m_object));
+      m_tag = VTAG_OBJECT;
+      rhs.reset();
+    } else {
+      m_int = rhs.m_int;
+      m_tag = rhs.m_tag;
+    }
+  }
+};
+
+} /* namespace ff */
+
+#endif /* _FF_VALUE_H_ */
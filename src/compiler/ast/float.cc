@@ -5,4 +5,8 @@ ff::ast::FloatLiteral::FloatLiteral(const Token& token) : Node(NTYPE_FLOAT_LITER
 
 float ff::ast::FloatLiteral::getValue() const {
   return m_value.toFloat();
-}
\ No newline at end of file
+}
+
+int ff::ast::FloatLiteral::getLine() const {
+  return m_value.line;
+}
@@ -9,3 +9,7 @@ std::string ff::ast::Identifier::getValue() const {
 std::string ff::ast::Identifier::toString() const {
   return m_value.str;
 }
+
+int ff::ast::Identifier::getLine() const {
+  return m_value.line;
+}
@@ -5,3 +5,7 @@ ff::ast::IntegerLiteral::IntegerLiteral(const Token& token) : Node(NTYPE_INTEGER
 int32_t ff::ast::IntegerLiteral::getValue() const {
   return m_value.toInteger();
 }
+
+int ff::ast::IntegerLiteral::getLine() const {
+  return m_value.line;
+}
@@ -5,3 +5,7 @@ ff::ast::StringLiteral::StringLiteral(const Token& token) : Node(NTYPE_STRING_LI
 std::string ff::ast::StringLiteral::getValue() const {
   return m_value.str;
 }
+
+int ff::ast::StringLiteral::getLine() const {
+  return m_value.line;
+}
@@ -6,6 +6,7 @@
 #include <ff/utils/str.h>
 #include <ff/builtins.h>
 #include <ff/memory.h>
+#include <ff/globals.h>
 #include <ff/config.h>
 #include <ff/types.h>
 #include <ff/log.h>
@@ -23,6 +24,35 @@
 
 using namespace ff::types;
 
+/* Line of the token that a node is built around (callee for calls, assignee for assignments), -1 if there is none */
+static int getNodeLine(ff::ast::Node* node) {
+  switch (node->getType()) {
+    case ff::ast::NTYPE_IDENTIFIER:      return node->as<ff::ast::Identifier>()->getLine();
+    case ff::ast::NTYPE_INTEGER_LITERAL: return node->as<ff::ast::IntegerLiteral>()->getLine();
+    case ff::ast::NTYPE_FLOAT_LITERAL:   return node->as<ff::ast::FloatLiteral>()->getLine();
+    case ff::ast::NTYPE_STRING_LITERAL:  return node->as<ff::ast::StringLiteral>()->getLine();
+    case ff::ast::NTYPE_BINARY_EXPR:     return node->as<ff::ast::Binary>()->getOperator().line;
+    case ff::ast::NTYPE_UNARY_EXPR:      return node->as<ff::ast::Unary>()->getOperator().line;
+    case ff::ast::NTYPE_VAR_DECL:        return node->as<ff::ast::VarDecl>()->getName().line;
+    case ff::ast::NTYPE_FUNCTION:        return node->as<ff::ast::Function>()->getName().line;
+    case ff::ast::NTYPE_CLASS:           return node->as<ff::ast::Class>()->getName().line;
+    case ff::ast::NTYPE_CALL:            return getNodeLine(node->as<ff::ast::Call>()->getCallee());
+    case ff::ast::NTYPE_ASSIGNMENT:      return getNodeLine(node->as<ff::ast::Assignment>()->getAssignee());
+    default:                             return -1;
+  }
+}
+
+/* Literal is evaluated by copying a constant, which must not be changed or kept by the consumer (see Compiler::evalNode) */
+static bool isLiteral(ff::ast::Node* node) {
+  return mrt::isIn(node->getType(), ff::ast::NTYPE_FLOAT_LITERAL, ff::ast::NTYPE_INTEGER_LITERAL, ff::ast::NTYPE_STRING_LITERAL);
+}
+
+/* Operators of these types are built-in and never keep or change their operands */
+static bool isBuiltinValueType(const ff::Ref<ff::TypeAnnotation>& type) {
+  return type->annotationType == ff::TypeAnnotation::TATYPE_DEFAULT && !type->isRef
+      && mrt::isIn(type->typeName, "int", "float", "bool", "string");
+}
+
 ff::Compiler::Variable::Variable(const std::string& name, Ref<TypeAnnotation> type, bool isConst, const std::map<std::string, Variable>& fields)
   : name(name), type(type), isConst(isConst), fields(fields) {}
 
@@ -46,13 +76,13 @@ ff::Compiler::Variable ff::Compiler::Variable::fromObject(const std::string& nam
     } else {
       var.type = TypeAnnotation::create(object.as<Instance>()->getType()->getTypeName());
     }
-    for (auto field : object->getFields()) {
-      var.fields[field.first] = Variable::fromObject(field.first, field.second);
+    for (auto& field : object.as<const Object>()->getFields()) {
+      var.fields[field.first.str()] = Variable::fromObject(field.first.str(), field.second);
     }
   } else if (object->isType()) {
     var.type = TypeAnnotation::create("type");
-    for (auto field : object->getFields()) {
-      var.fields[field.first] = Variable::fromObject(field.first, field.second);
+    for (auto& field : object.as<const Object>()->getFields()) {
+      var.fields[field.first.str()] = Variable::fromObject(field.first.str(), field.second);
     }
   } else {
     throw CompileError("", -1, "Unknown type of object");
@@ -140,7 +170,7 @@ void ff::CompileError::print() const {
   }
 }
 
-ff::Compiler::Compiler() {
+ff::Compiler::Compiler() : m_copyElision(config::get("copy_elision") != "0") {
   // NOTE: Initialize info about built-in types
   m_globalVariables["int"] = Variable::fromObject("int", IntType::getInstance().asRefTo<Object>());
   m_globalVariables["float"] = Variable::fromObject("float", FloatType::getInstance().asRefTo<Object>());
@@ -167,6 +197,7 @@ ff::Ref<ff::Code> ff::Compiler::compile(const std::string& filename, ast::Node*
   m_filename = filename;
 
   evalNode(node);
+  getCode()->pushInstruction(OP_HALT);
 
 #ifdef _FF_DEBUG_GLOBALS
   if (config::get("debug") != "0") {
@@ -313,6 +344,29 @@ void ff::Compiler::emitConstant(Ref<Object> obj) {
   getCode()->push<uint32_t>(constant);
 }
 
+void ff::Compiler::emitMember(Opcode op, const std::string& name) {
+  getCode()->push<uint8_t>(op);
+  getCode()->push<uint32_t>(getCode()->addSymbol(name));
+  getCode()->push<uint32_t>(getCode()->addInlineCache());
+}
+
+void ff::Compiler::emitField(Opcode op, const std::string& name) {
+  getCode()->push<uint8_t>(op);
+  getCode()->push<uint32_t>(getCode()->addSymbol(name));
+}
+
+void ff::Compiler::emitSlot(Opcode op, uint32_t slot, const std::string& name) {
+  getCode()->push<uint8_t>(op);
+  getCode()->push<uint32_t>(slot);
+  getCode()->push<uint32_t>(getCode()->addSymbol(name));
+  getCode()->push<uint32_t>(getCode()->addInlineCache());
+}
+
+void ff::Compiler::emitGlobal(Opcode op, const std::string& name) {
+  getCode()->push<uint8_t>(op);
+  getCode()->push<uint32_t>(getCode()->addGlobal(globals::getSlot(name)));
+}
+
 void ff::Compiler::emitCall(const std::string& callee) {
   resolveVariable(callee);
   getCode()->push<uint8_t>(OP_CALL);
@@ -348,7 +402,7 @@ void ff::Compiler::emitLoop(int loopStart) {
   getCode()->push<uint16_t>(offset);
 }
 
-ff::Ref<ff::TypeAnnotation> ff::Compiler::resolveVariable(const std::string& name, Opcode local, Opcode global, bool checkIsConst) {
+ff::Compiler::Variable* ff::Compiler::resolveLocal(const std::string& name, uint32_t& index) {
   int localsSize = 0;
   for (int i = m_scopes.size() - 1; i > 0; i--) {
     localsSize += m_scopes[i].localVariables.size();
@@ -356,22 +410,35 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::resolveVariable(const std::string& nam
   }
   for (int i = m_scopes.size() - 1; i > 0; i--) {
     localsSize -= m_scopes[i].localVariables.size();
-    auto itr = std::find_if(m_scopes[i].localVariables.begin(), m_scopes[i].localVariables.end(), [&name](auto var) {
+    auto itr = std::find_if(m_scopes[i].localVariables.begin(), m_scopes[i].localVariables.end(), [&name](auto& var) {
       return var.name == name;
     });
     if (itr != m_scopes[i].localVariables.end()) {
-      getCode()->push<uint8_t>(local);
-      getCode()->push<uint32_t>(itr - m_scopes[i].localVariables.begin() + localsSize);
-      if (checkIsConst && itr->isConst) {
-        throw CompileError(m_filename, -1, "Cannot assign to const variable '%s'", itr->name.c_str());
+      index = itr - m_scopes[i].localVariables.begin() + localsSize;
+      // Arguments are pushed last to first, so they occupy the frame's first slots in reverse
+      if (m_scopes[i].type == SCOPE_FUNCTION && index < m_scopes[i].argCount) {
+        index = m_scopes[i].argCount - 1 - index;
       }
-      return itr->type;
+      return &*itr;
     }
   }
+  return nullptr;
+}
+
+ff::Ref<ff::TypeAnnotation> ff::Compiler::resolveVariable(const std::string& name, Opcode local, Opcode global, bool checkIsConst) {
+  uint32_t index = 0;
+  Variable* var = resolveLocal(name, index);
+  if (var) {
+    getCode()->push<uint8_t>(local);
+    getCode()->push<uint32_t>(index);
+    if (checkIsConst && var->isConst) {
+      throw CompileError(m_filename, -1, "Cannot assign to const variable '%s'", var->name.c_str());
+    }
+    return var->type;
+  }
   auto itr = m_globalVariables.find(name);
   if (itr != m_globalVariables.end()) {
-    emitConstant(String::createInstance(name).asRefTo<Object>());
-    getCode()->push<uint8_t>(global);
+    emitGlobal(global, name);
     if (checkIsConst && itr->second.isConst) {
       throw CompileError(m_filename, -1, "Cannot assign to const variable '%s'", itr->second.name.c_str());
     }
@@ -441,19 +508,16 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::resolveVariableRelativeToModule(const
     }
   }
 
-  emitConstant(String::createInstance(typeInfo.front().var->name).asRefTo<Object>());
-  getCode()->pushInstruction(OP_GET_GLOBAL);
+  emitGlobal(OP_GET_GLOBAL, typeInfo.front().var->name);
 
   for (auto i = typeInfo.begin() + 1; i <= varModItr; i++) {
-    emitConstant(String::createInstance(i->var->name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_GET_FIELD);
+    emitMember(OP_GET_FIELD, i->var->name);
   }
 
-  emitConstant(String::createInstance(name).asRefTo<Object>());
   if (set) {
-    getCode()->pushInstruction(OP_SET_FIELD);
+    emitField(OP_SET_FIELD, name);
   } else {
-    getCode()->pushInstruction(OP_GET_FIELD);
+    emitMember(OP_GET_FIELD, name);
   }
 
   return typeInfo.back().type;
@@ -520,16 +584,14 @@ ff::Compiler::TypeInfo ff::Compiler::resolveCurrentModule() {
 
   auto itr = m_globalVariables.find(rootModuleName);
   if (itr != m_globalVariables.end()) {
-    emitConstant(String::createInstance(rootModuleName).asRefTo<Object>());
-    getCode()->push<uint8_t>(OP_GET_GLOBAL);
+    emitGlobal(OP_GET_GLOBAL, rootModuleName);
 
     typeInfo.push_back({itr->second.type, &itr->second});
 
     for (int i = 1; i < m_modules.size(); i++) {
       auto fitr = typeInfo.back().var->fields.find(m_modules[i]);
       if (fitr != typeInfo.back().var->fields.end()) {
-        emitConstant(String::createInstance(fitr->second.name).asRefTo<Object>());
-        getCode()->pushInstruction(OP_GET_FIELD);
+        emitMember(OP_GET_FIELD, fitr->second.name);
 
         typeInfo.push_back({fitr->second.type, &fitr->second});
       } else {
@@ -544,6 +606,46 @@ ff::Compiler::TypeInfo ff::Compiler::resolveCurrentModule() {
   return typeInfo.back();
 }
 
+bool ff::Compiler::isBorrowingMethod(Ref<TypeAnnotation> receiverType, const std::string& name) const {
+  if (receiverType->annotationType != TypeAnnotation::TATYPE_DEFAULT || receiverType->isRef) {
+    return false;
+  }
+  // Members are looked up in the receiver's fields first, so only types whose instances have no fields qualify.
+  // Methods of built-in types are immortal objects and can't be replaced (see ff/isolate.h)
+  Ref<Type> type;
+  if (receiverType->typeName == "string") {
+    type = StringType::getInstance().asRefTo<Type>();
+  } else if (receiverType->typeName == "vector") {
+    type = VectorType::getInstance().asRefTo<Type>();
+  } else {
+    return false;
+  }
+  if (!type->hasField(name)) {
+    return false;
+  }
+  auto method = type->getField(name);
+  return isOfType(method, NativeFunctionType::getInstance()) && method.as<NativeFunction>()->borrowsArgs;
+}
+
+const ff::Compiler::ClassShape* ff::Compiler::getReceiverShape(ast::Node* node, Ref<TypeAnnotation> type) {
+  std::string className;
+  if (type->annotationType == TypeAnnotation::TATYPE_DEFAULT) {
+    className = type->typeName;
+  }
+  if (node && node->getType() == ast::NTYPE_IDENTIFIER && m_classShapes.find(className) == m_classShapes.end()) {
+    int i = m_scopes.size() - 1;
+    while (!m_scopes[i].isFunctionScope && i > 0) {
+      i--;
+    }
+    const Scope& scope = m_scopes[i];
+    if (!scope.selfClass.empty() && scope.argCount > 0 && scope.localVariables[0].name == node->as<ast::Identifier>()->getValue()) {
+      className = scope.selfClass;
+    }
+  }
+  auto itr = m_classShapes.find(className);
+  return itr != m_classShapes.end() ? &itr->second : nullptr;
+}
+
 std::vector<ff::Function::Argument> ff::Compiler::parseArgs(ast::VarDeclList* args) {
   std::vector<Function::Argument> result;
   if (args) {
@@ -572,6 +674,7 @@ void ff::Compiler::defineArgs(ast::VarDeclList* args) {
       }
       getLocals().push_back(var);
     }
+    m_scopes.back().argCount = args->getList().size();
   }
 }
 
@@ -579,8 +682,11 @@ ff::Compiler::TypeInfo ff::Compiler::evalSequenceElement(TypeInfo prev, ast::Nod
   isCopyable = true;
   if (node->getType() == ast::NTYPE_IDENTIFIER) {
     std::string name = node->as<ast::Identifier>()->getValue();
-    emitConstant(String::createInstance(name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_GET_FIELD);
+    if (prev.shape && prev.shape->find(name) != prev.shape->end()) {
+      emitSlot(OP_GET_SLOT, prev.shape->at(name), name);
+    } else {
+      emitMember(OP_GET_FIELD, name);
+    }
     Variable* var = nullptr;
     auto type = TypeAnnotation::any();
     if (prev.var) {
@@ -592,7 +698,7 @@ ff::Compiler::TypeInfo ff::Compiler::evalSequenceElement(TypeInfo prev, ast::Nod
     if (type->annotationType == TypeAnnotation::TATYPE_FUNCTION || type->typeName == "type") {
       isCopyable = false;
     }
-    return {type, var};
+    return {type, var, getReceiverShape(nullptr, type)};
   } else if (node->getType() == ast::NTYPE_CALL) {
     bool explicitSelf = false;
     if (prev.var) {
@@ -613,14 +719,15 @@ ff::Compiler::TypeInfo ff::Compiler::evalSequenceElement(TypeInfo prev, ast::Nod
 ff::Compiler::TypeInfo ff::Compiler::evalSequenceStart(ast::Node* node) {
   if (node->getType() == ast::NTYPE_IDENTIFIER) {
     std::string name = node->as<ast::Identifier>()->getValue();
-    auto type = resolveVariable(name);
+    // Fields and methods operate on the variable's object itself, so unboxed local gets boxed in place
+    auto type = resolveVariable(name, OP_REF_LOCAL);
     if (m_globalVariables.find(name) != m_globalVariables.end()) {
-      return {type, &m_globalVariables[name]};
+      return {type, &m_globalVariables[name], getReceiverShape(node, type)};
     }
-    return {type, nullptr};
+    return {type, nullptr, getReceiverShape(node, type)};
   } else if (node->getType() == ast::NTYPE_CALL) { // Call
     auto type = call(node, true);
-    return {type, nullptr};
+    return {type, nullptr, getReceiverShape(nullptr, type)};
   } else {
     throw CompileError(m_filename, -1, "Expected identifier or call");
   }
@@ -653,8 +760,10 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::sequence(ast::Node* node, bool copyVal
 
 ff::Ref<ff::TypeAnnotation> ff::Compiler::binaryExpr(ast::Node* node) {
   ast::Binary* binary = node->as<ast::Binary>();
+  // Operator is looked up on the left operand, so a literal on the right is only safe to pass if that's a built-in type
   auto leftType = evalNode(binary->getLeft(), false);
-  auto rightType = evalNode(binary->getRight(), false);
+  auto rightType = evalNode(binary->getRight(), isLiteral(binary->getRight()) && !isBuiltinValueType(leftType));
+  getCode()->setLine(binary->getOperator().line);
   // TODO: Infer type from globals[leftType]->fields[__add__]->returnType, if impossible - return leftType
   switch (binary->getOperator().type) {
     case TOKEN_PLUS: {
@@ -718,7 +827,18 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::binaryExpr(ast::Node* node) {
 
 ff::Ref<ff::TypeAnnotation> ff::Compiler::unaryExpr(ast::Node* node) {
   ast::Unary* unary = node->as<ast::Unary>();
-  auto type = evalNode(unary->getValue(), false);
+  auto opType = unary->getOperator().type;
+  // ++/-- on a local is done in place, since the local may hold an unboxed value
+  if ((opType == TOKEN_INCREMENT || opType == TOKEN_DECREMENT) && unary->getValue()->getType() == ast::NTYPE_IDENTIFIER) {
+    uint32_t index = 0;
+    Variable* var = resolveLocal(unary->getValue()->as<ast::Identifier>()->getValue(), index);
+    if (var) {
+      getCode()->pushInstruction(opType == TOKEN_INCREMENT ? OP_INC_LOCAL : OP_DEC_LOCAL);
+      getCode()->push<uint32_t>(index);
+      return var->type;
+    }
+  }
+  auto type = evalNode(unary->getValue(), (opType == TOKEN_INCREMENT || opType == TOKEN_DECREMENT) && isLiteral(unary->getValue()));
   switch (unary->getOperator().type) {
     case TOKEN_BANG: {
       getCode()->pushInstruction(OP_NOT);
@@ -765,8 +885,12 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::fndecl(ast::Node* node, bool isModule,
     }
   }
 
+  std::string selfClass = m_methodClass;
+  m_methodClass.clear(); // Functions declared in a method aren't methods
+
   beginFunctionScope(fn->getFunctionType()->returnType);
   defineArgs(fn->getArgs());
+  m_scopes.back().selfClass = selfClass;
   auto bodyType = evalNode(fn->getBody(), true, isModule);
   Scope scope = endScope();
 
@@ -798,8 +922,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::fndecl(ast::Node* node, bool isModule,
   }
 
   if (saveToVariable && !isModule) {
-    emitConstant(String::createInstance(fn->getName().str).asRefTo<Object>());
-    getCode()->pushInstruction(OP_NEW_GLOBAL);
+    emitGlobal(OP_NEW_GLOBAL, fn->getName().str);
   }
 
   if (saveToVariable) {
@@ -826,11 +949,9 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::fndecl(ast::Node* node, bool isModule,
     if (isModule) {
       TypeInfo typeInfo = resolveCurrentModule();
       typeInfo.var->fields[var.name] = var;
-      emitConstant(String::createInstance(fn->getName().str).asRefTo<Object>());
-      getCode()->pushInstruction(OP_SET_FIELD);
+      emitField(OP_SET_FIELD, fn->getName().str);
     } else {
-      emitConstant(String::createInstance(fn->getName().str).asRefTo<Object>());
-      getCode()->pushInstruction(OP_SET_GLOBAL);
+      emitGlobal(OP_SET_GLOBAL, fn->getName().str);
     }
   }
 
@@ -861,8 +982,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::classdecl(ast::Node* node, bool isModu
   Ref<Class> classObject = Class::createInstance(var.name);
 
   if (!isModule) {
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_NEW_GLOBAL);
+    emitGlobal(OP_NEW_GLOBAL, var.name);
   }
 
   emitConstant(classObject.asRefTo<Object>());
@@ -871,13 +991,13 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::classdecl(ast::Node* node, bool isModu
   if (isModule) {
     TypeInfo typeInfo = resolveCurrentModule();
     typeInfo.var->fields[var.name] = var;
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_SET_FIELD);
+    emitField(OP_SET_FIELD, var.name);
   } else {
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_SET_GLOBAL);
+    emitGlobal(OP_SET_GLOBAL, var.name);
   }
 
+  // Slots are assigned in the same order addField adds fields at runtime
+  ClassShape shape;
   for (auto& field : classNode->getFields()) {
     var.fields[field.name.str] = Variable {
       field.name.str,
@@ -885,6 +1005,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::classdecl(ast::Node* node, bool isModu
       false,
       {}
     };
+    shape.emplace(field.name.str, shape.size());
 
     getCode()->pushInstruction(OP_DUP);
     ast::Node* call_ = new ast::Call(
@@ -895,6 +1016,10 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::classdecl(ast::Node* node, bool isModu
     call(call_, false, {type, nullptr});
   }
 
+  if (!isModule) {
+    m_classShapes[var.name] = shape;
+  }
+
   for (auto& method : classNode->getMethods()) {
     var.fields[method.fn->getName().str] = Variable {
       method.fn->getName().str,
@@ -910,7 +1035,9 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::classdecl(ast::Node* node, bool isModu
       {new ast::StringLiteral(method.fn->getName()), method.fn},
       false
     );
+    m_methodClass = isModule ? "" : var.name;
     call(call_, false, {type, nullptr});
+    m_methodClass.clear();
   }
 
   getCode()->pushInstruction(OP_POP);
@@ -959,16 +1086,14 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::vardecl(ast::Node* node, bool copyValu
         typeInfo.var->fields[var.name].type = type;
       }
 
-      emitConstant(String::createInstance(var.name).template asRefTo<Object>());
-      getCode()->pushInstruction(OP_SET_FIELD);
+      emitField(OP_SET_FIELD, var.name);
       return typeInfo.var->fields[var.name].type;
     } else {
       if (m_globalVariables.find(var.name) != m_globalVariables.end()) {
         throw CompileError(m_filename, varNode->getName().line, "Redeclaration of global variable");
       }
       m_globalVariables[var.name] = var;
-      emitConstant(String::createInstance(var.name).asRefTo<Object>());
-      getCode()->pushInstruction(OP_NEW_GLOBAL);
+      emitGlobal(OP_NEW_GLOBAL, var.name);
 
       auto type = evalNode(varNode->getValue(), copyValue);
       if (*type == *TypeAnnotation::nothing()) {
@@ -988,8 +1113,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::vardecl(ast::Node* node, bool copyValu
         }
         m_globalVariables[var.name].type = type;
       }
-      emitConstant(String::createInstance(var.name).asRefTo<Object>());
-      getCode()->pushInstruction(OP_SET_GLOBAL);
+      emitGlobal(OP_SET_GLOBAL, var.name);
     }
     return m_globalVariables[var.name].type;
   } else {
@@ -999,7 +1123,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::vardecl(ast::Node* node, bool copyValu
   return TypeAnnotation::any();
 }
 
-ff::Ref<ff::TypeAnnotation> ff::Compiler::call(ast::Node* node, bool topLevelCallee, TypeInfo typeInfo, bool explicitSelf) {
+ff::Ref<ff::TypeAnnotation> ff::Compiler::call(ast::Node* node, bool topLevelCallee, TypeInfo typeInfo, bool explicitSelf, bool isTailCall) {
   ast::Call* call = node->as<ast::Call>();
 
   if (call->getCallee()->getType() != ast::NTYPE_IDENTIFIER) {
@@ -1040,9 +1164,10 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::call(ast::Node* node, bool topLevelCal
   }
 
   auto args = call->getArgs();
+  bool borrowsArgs = m_copyElision && !topLevelCallee && !explicitSelf && isBorrowingMethod(typeInfo.type, functionName);
 
   for (int i = args.size() - 1; i >= 0; i--) {
-    auto argType = evalNode(args[i], true, false, false);
+    auto argType = evalNode(args[i], !borrowsArgs, false, false);
     if (type->annotationType == TypeAnnotation::TATYPE_FUNCTION) {
       if ((type.asRefTo<FunctionAnnotation>()->arguments.size() != args.size() && topLevelCallee)
        || (type.asRefTo<FunctionAnnotation>()->arguments.size()-1 != args.size() && !topLevelCallee && !explicitSelf)) {
@@ -1081,13 +1206,13 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::call(ast::Node* node, bool topLevelCal
 
   if (topLevelCallee) {
     evalNode(call->getCallee(), false);
-    getCode()->pushInstruction(OP_CALL);
+    getCode()->pushInstruction(isTailCall ? OP_TAIL_CALL : OP_CALL);
   } else {
     size_t nargs = call->getArgs().size();
+    getCode()->setLine(getNodeLine(call->getCallee()));
     getCode()->pushInstruction(OP_PULL_UP);
     getCode()->push<uint16_t>(nargs + 2);
-    emitConstant(String::createInstance(call->getCallee()->as<ast::Identifier>()->getValue()).asRefTo<Object>());
-    getCode()->pushInstruction(OP_CALL_MEMBER);
+    emitMember(OP_CALL_MEMBER, call->getCallee()->as<ast::Identifier>()->getValue());
   }
 
   if (!call->isReturnValueExpected()) {
@@ -1130,8 +1255,7 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::callMember(const std::string& memberNa
   size_t nargs = args.size();
   getCode()->pushInstruction(OP_PULL_UP);
   getCode()->push<uint16_t>(nargs + 2);
-  emitConstant(String::createInstance(memberName).asRefTo<Object>());
-  getCode()->pushInstruction(OP_CALL_MEMBER);
+  emitMember(OP_CALL_MEMBER, memberName);
 
   if (!isReturnValueExpected) {
     getCode()->pushInstruction(OP_POP);
@@ -1195,13 +1319,12 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::assignment(ast::Node* node, bool copyV
   if (ass->getAssignee()->getType() == ast::NTYPE_SEQUENCE) {
     auto seq = ass->getAssignee()->as<ast::Sequence>()->getSequence();
 
-    evalNode(seq.front(), false);
+    TypeInfo receiver = evalSequenceStart(seq.front());
 
     if (seq.size() > 2) {
       for (int i = 1; i < seq.size()-1; i++) {
         if (seq[i]->getType() == ast::NTYPE_IDENTIFIER) {
-          emitConstant(String::createInstance(seq[i]->as<ast::Identifier>()->getValue()).asRefTo<Object>());
-          getCode()->pushInstruction(OP_GET_FIELD);
+          emitMember(OP_GET_FIELD, seq[i]->as<ast::Identifier>()->getValue());
         } else if (seq[i]->getType() == ast::NTYPE_CALL) { // is this even legal?
           call(seq[i], false);
         } else {
@@ -1212,8 +1335,12 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::assignment(ast::Node* node, bool copyV
     if (seq.back()->getType() != ast::NTYPE_IDENTIFIER) {
       throw CompileError(m_filename, -1, "Cannot set anything other than a field");
     }
-    emitConstant(String::createInstance(seq.back()->as<ast::Identifier>()->getValue()).asRefTo<Object>());
-    getCode()->pushInstruction(ass->getIsRefAssignment() ? OP_SET_FIELD_REF : OP_SET_FIELD);
+    std::string name = seq.back()->as<ast::Identifier>()->getValue();
+    if (seq.size() == 2 && receiver.shape && receiver.shape->find(name) != receiver.shape->end() && !ass->getIsRefAssignment()) {
+      emitSlot(OP_SET_SLOT, receiver.shape->at(name), name);
+    } else {
+      emitField(ass->getIsRefAssignment() ? OP_SET_FIELD_REF : OP_SET_FIELD, name);
+    }
   } else if (ass->getAssignee()->getType() == ast::NTYPE_IDENTIFIER) {
     auto variableType = resolveVariable(
       ass->getAssignee()->as<ast::Identifier>()->getValue(),
@@ -1234,7 +1361,8 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::assignment(ast::Node* node, bool copyV
 
 ff::Ref<ff::TypeAnnotation> ff::Compiler::cast(ast::Node* node, bool copyValue) {
   ast::Cast* cast = node->as<ast::Cast>();
-  evalNode(cast->getValue());
+  // Value is copied at most once, right below
+  evalNode(cast->getValue(), !m_copyElision);
   // NOTE: cast type can be anything (i.e. int | float | (int) -> int), so it must be checked that we recieved a concrete type
   if (cast->getCastType()->annotationType != TypeAnnotation::TATYPE_DEFAULT) {
     throw CompileError(m_filename, -1, "Invalid type for cast '%s'", cast->getCastType()->toString().c_str());
@@ -1252,7 +1380,20 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::cast(ast::Node* node, bool copyValue)
 
 ff::Ref<ff::TypeAnnotation> ff::Compiler::ref(ast::Node* node) {
   ast::Ref* ref = node->as<ast::Ref>();
-  auto type = evalNode(ref->getValue(), false);
+  Ref<TypeAnnotation> type;
+  uint32_t index = 0;
+  Variable* var = nullptr;
+  if (ref->getValue()->getType() == ast::NTYPE_IDENTIFIER) {
+    var = resolveLocal(ref->getValue()->as<ast::Identifier>()->getValue(), index);
+  }
+  if (var) {
+    // Boxes the local in place, so the reference and the variable share the same object
+    getCode()->pushInstruction(OP_REF_LOCAL);
+    getCode()->push<uint32_t>(index);
+    type = var->type;
+  } else {
+    type = evalNode(ref->getValue(), isLiteral(ref->getValue()));
+  }
   type = type->copy();
   type->isRef = true;
   return type;
@@ -1277,7 +1418,14 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::newexpr(ast::Node* node) {
 }
 
 void ff::Compiler::returnCall(ast::Node* node) {
-  auto type = evalNode(node->as<ast::Return>()->getValue());
+  ast::Node* value = node->as<ast::Return>()->getValue();
+  Ref<TypeAnnotation> type;
+  if (value && value->getType() == ast::NTYPE_CALL && value->as<ast::Call>()->isReturnValueExpected()) {
+    // `return f(...)` reuses the current frame for f (OP_RETURN after it is never reached)
+    type = call(value, true, {TypeAnnotation::any(), nullptr}, false, true);
+  } else {
+    type = evalNode(value);
+  }
 
   int i = m_scopes.size() - 1;
   while (!m_scopes[i].isFunctionScope && i > 0) {
@@ -1321,11 +1469,10 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::dict(ast::Node* node) {
     auto type = evalNode(p.second); // value
     bool isRef = p.second->getType() == ast::NTYPE_REF;
 
-    getCode()->pushInstruction(OP_PULL_UP); // OP_SET_FIELD expects [ field, object, value ]
+    getCode()->pushInstruction(OP_PULL_UP); // OP_SET_FIELD expects [ object, value ]
     getCode()->push<uint16_t>(2);
 
-    emitConstant(String::createInstance(p.first).asRefTo<Object>()); // field
-    getCode()->pushInstruction(isRef ? OP_SET_FIELD_REF : OP_SET_FIELD);
+    emitField(isRef ? OP_SET_FIELD_REF : OP_SET_FIELD, p.first);
   }
 
   return TypeAnnotation::create("dict");
@@ -1351,11 +1498,12 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::vector(ast::Node* node) {
 void ff::Compiler::block(ast::Node* node) {
   beginBlock();
   for (auto bodyNode : node->as<ast::Block>()->getBody()) {
-    evalNode(bodyNode);
-    if (mrt::isIn(bodyNode->getType(),
+    bool isDiscarded = mrt::isIn(bodyNode->getType(),
         ast::NTYPE_BINARY_EXPR, ast::NTYPE_UNARY_EXPR,
         ast::NTYPE_FLOAT_LITERAL, ast::NTYPE_INTEGER_LITERAL, ast::NTYPE_STRING_LITERAL,
-        ast::NTYPE_NULL, ast::NTYPE_TRUE, ast::NTYPE_FALSE, ast::NTYPE_REF)) {
+        ast::NTYPE_NULL, ast::NTYPE_TRUE, ast::NTYPE_FALSE, ast::NTYPE_REF);
+    evalNode(bodyNode, !isDiscarded);
+    if (isDiscarded) {
       getCode()->pushInstruction(OP_POP);
     }
   }
@@ -1472,13 +1620,10 @@ void ff::Compiler::forstmt(ast::Node* node) {
   endBlock();
 }
 
-void ff::Compiler::import(ast::Node* node, bool isModule) {
-  ast::Import* imp = node->as<ast::Import>();
-
+std::vector<std::string> ff::Compiler::getImportPaths(const std::string& filename) {
   std::string cwd = path::getcwd();
-  std::string filedir = path::isRoot(m_filename) ? path::getFolder(m_filename) : path::concat(cwd, path::getFolder(m_filename));
+  std::string filedir = path::isRoot(filename) ? path::getFolder(filename) : path::concat(cwd, path::getFolder(filename));
 
-  // Generate import paths
   std::vector<std::string> importPaths = {filedir, cwd};
 
   const char* envImportPath = std::getenv(FF_IMPORT_PATH_ENV_VAR);
@@ -1490,6 +1635,14 @@ void ff::Compiler::import(ast::Node* node, bool isModule) {
   auto configImportPaths = mrt::str::split(config::get("import_path"), ":");
   importPaths.insert(importPaths.end(), configImportPaths.begin(), configImportPaths.end());
 
+  return importPaths;
+}
+
+void ff::Compiler::import(ast::Node* node, bool isModule) {
+  ast::Import* imp = node->as<ast::Import>();
+
+  std::vector<std::string> importPaths = getImportPaths(m_filename);
+
   // Import modules
   for (auto& import : imp->getImports()) {
     std::string name = path::stripExtension(path::getFile(import));
@@ -1501,15 +1654,10 @@ void ff::Compiler::import(ast::Node* node, bool isModule) {
       throw CompileError(m_filename, -1, "Circular import detected (module '%s' from module '%s')", name.c_str(), m_thisModuleName.empty() ? "<no name>" : m_thisModuleName.c_str());
     }
 
-    ModuleInfo modInfo;
-    std::string fullPath = config::format(path::getImportFileFromPath(import, importPaths));
-    if (mrt::str::endsWith(fullPath, ".ffmod") || mrt::str::endsWith(fullPath, ".so")) {
-      modInfo = loadNativeModule(name, fullPath);
-    } else {
-      modInfo = loadModule(name, fullPath, m_thisModuleName);
-    }
+    std::string fullPath = config::format(resolveImport(import, importPaths));
+    ModuleInfo modInfo = importModule(name, fullPath, m_thisModuleName);
 
-    getCode()->addModule(name, modInfo.module.asRefTo<Object>());
+    getCode()->addModule(name, modInfo.module.asRefTo<Object>(), fullPath);
     m_globalVariables[name] = modInfo.var;
     m_imports.push_back(name);
 
@@ -1542,20 +1690,17 @@ void ff::Compiler::module(ast::Node* node, bool isModule) {
     typeInfo.var->fields[var.name] = var;
     emitConstant(Module::createInstance(var.name).asRefTo<Object>());
     getCode()->pushInstruction(OP_ROL);
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_SET_FIELD);
+    emitField(OP_SET_FIELD, var.name);
   } else {
     if (m_globalVariables.find(var.name) != m_globalVariables.end()) {
       throw CompileError(m_filename, -1, "Redeclaration of global variable");
     }
     m_globalVariables[var.name] = var;
 
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_NEW_GLOBAL);
+    emitGlobal(OP_NEW_GLOBAL, var.name);
 
     emitConstant(Module::createInstance(var.name).asRefTo<Object>());
-    emitConstant(String::createInstance(var.name).asRefTo<Object>());
-    getCode()->pushInstruction(OP_SET_GLOBAL);
+    emitGlobal(OP_SET_GLOBAL, var.name);
   }
 
   m_modules.push_back(var.name);
@@ -1567,6 +1712,9 @@ void ff::Compiler::module(ast::Node* node, bool isModule) {
 
 ff::Ref<ff::TypeAnnotation> ff::Compiler::evalNode(ast::Node* node, bool copyValue, bool isModule, bool saveToVariable) {
   if (!node) return TypeAnnotation::nothing();
+  if (!m_scopes.empty()) {
+    getCode()->setLine(getNodeLine(node));
+  }
 #ifdef _FF_EVAL_NODE_DEBUG
   if (config::get("debug") != "0") {
     printf("evalNode: ptr=%p type=%s\n", node, ast::nodeTypeToString(node->getType()).c_str());
@@ -1575,17 +1723,23 @@ ff::Ref<ff::TypeAnnotation> ff::Compiler::evalNode(ast::Node* node, bool copyVal
   switch (node->getType()) {
     case ast::NTYPE_FLOAT_LITERAL: {
       emitConstant(Float::createInstance(node->as<ast::FloatLiteral>()->getValue()).asRefTo<Object>());
-      getCode()->pushInstruction(OP_COPY);
+      if (copyValue || !m_copyElision) {
+        getCode()->pushInstruction(OP_COPY);
+      }
       return TypeAnnotation::create("float");
     }
     case ast::NTYPE_INTEGER_LITERAL: {
       emitConstant(Int::createInstance(node->as<ast::IntegerLiteral>()->getValue()).asRefTo<Object>());
-      getCode()->pushInstruction(OP_COPY);
+      if (copyValue || !m_copyElision) {
+        getCode()->pushInstruction(OP_COPY);
+      }
       return TypeAnnotation::create("int");
     }
     case ast::NTYPE_STRING_LITERAL: {
       emitConstant(String::createInstance(node->as<ast::StringLiteral>()->getValue()).asRefTo<Object>());
-      getCode()->pushInstruction(OP_COPY);
+      if (copyValue || !m_copyElision) {
+        getCode()->pushInstruction(OP_COPY);
+      }
       return TypeAnnotation::create("string");
     }
     case ast::NTYPE_NULL: {
@@ -257,7 +257,7 @@ ff::ast::Node* ff::Parser::vardecl(bool isConst) {
     throw ParseError(peek(), m_filename, "Expected an identifier after 'var'");
   }
   Token name = previous();
-  Ref<TypeAnnotation> type = TypeAnnotation::any();
+  Ref<TypeAnnotation> type = TypeAnnotation::create("any"); // Not any(), its reference count isn't safe to touch from parser threads
   ast::Node* value = nullptr;
   if (match({TOKEN_COLON})) {
     type = typeAnnotation();
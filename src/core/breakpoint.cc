@@ -29,7 +29,7 @@ void ff::VM::runtimeBreakpoint() {
         if (tokens[1] == "print") {
           printStack();
         } else if (tokens[1] == "pop") {
-          printf("%s\n", pop()->toString().c_str());
+          printf("%s\n", pop().toString().c_str());
         } else {
           printf("%s\n", _CMD_STACK_HELP);
         }
@@ -6,7 +6,7 @@
 using namespace ff::types;
 
 ff::Ref<ff::NativeFunction> ff::fn_exit = fn(
-  [](ff::VM* context, std::vector<ff::Ref<ff::Object>> args) {
+  [](ff::VM* context, ff::NativeArgs args) {
     context->stop();
     context->setReturnCode(intval(args[0]));
     return ff::Ref<ff::Object>();
@@ -16,7 +16,7 @@ ff::Ref<ff::NativeFunction> ff::fn_exit = fn(
 );
 
 ff::Ref<ff::NativeFunction> ff::fn_assert = fn(
-  [](ff::VM* context, std::vector<ff::Ref<ff::Object>> args) {
+  [](ff::VM* context, ff::NativeArgs args) {
     if (!ff::Object::toBool(context, args[0])) {
       throw ff::RuntimeError::createf("Assertion Failed");
     }
@@ -27,7 +27,7 @@ ff::Ref<ff::NativeFunction> ff::fn_assert = fn(
 );
 
 ff::Ref<ff::NativeFunction> ff::fn_type = fn(
-  [](ff::VM* context, std::vector<ff::Ref<ff::Object>> args) {
+  [](ff::VM* context, ff::NativeArgs args) {
     if (!args[0].get()) {
       return obj(string("null"));
     }
@@ -47,26 +47,30 @@ ff::Ref<ff::NativeFunction> ff::fn_type = fn(
 
 
 ff::Ref<ff::NativeFunction> ff::fn_inspect = fn(
-  [](ff::VM* context, std::vector<ff::Ref<ff::Object>> args) {
+  [](ff::VM* context, ff::NativeArgs args) {
     if (!args[0].get()) {
       printf("null");
       return ff::Ref<ff::Object>();
     }
     if (args[0]->isInstance()) {
       if (args[0].as<ff::Instance>()->getType() == ff::ClassInstanceType::getInstance().asRefTo<Type>()) {
-        printf("ClassInstance: %s\n", args[0].as<ff::ClassInstance>()->getClass()->className.c_str());
-        for (auto& [fieldName, field] : args[0].as<ff::ClassInstance>()->getFields()) {
+        auto instance = args[0].as<ff::ClassInstance>();
+        printf("ClassInstance: %s\n", instance->getClass()->className.c_str());
+        for (size_t i = 0; i < instance->getSlotCount(); i++) {
+          printf("  %s: %s\n", instance->getClass()->shape.names[i].c_str(), instance->getSlot(i)->toString().c_str());
+        }
+        for (auto& [fieldName, field] : args[0].as<const ff::Object>()->getSortedFields()) {
           printf("  %s: %s\n", fieldName.c_str(), field->toString().c_str());
         }
       } else {
         printf("Instance: %s\n", args[0].as<ff::Instance>()->getType()->getTypeName().c_str());
-        for (auto& [fieldName, field] : args[0].as<ff::ClassInstance>()->getFields()) {
+        for (auto& [fieldName, field] : args[0].as<const ff::Object>()->getSortedFields()) {
           printf("  %s: %s\n", fieldName.c_str(), field->toString().c_str());
         }
       }
     } else {
       printf("Type: %s\n", args[0].as<ff::Type>()->getTypeName().c_str());
-      for (auto& [fieldName, field] : args[0].as<ff::ClassInstance>()->getFields()) {
+      for (auto& [fieldName, field] : args[0].as<const ff::Object>()->getSortedFields()) {
           printf("  %s: %s\n", fieldName.c_str(), field->toString().c_str());
         }
     }
@@ -77,7 +81,7 @@ ff::Ref<ff::NativeFunction> ff::fn_inspect = fn(
 );
 
 ff::Ref<ff::NativeFunction> ff::fn_memaddr = fn(
-  [](ff::VM* context, std::vector<ff::Ref<ff::Object>> args) {
+  [](ff::VM* context, ff::NativeArgs args) {
     if (!args[0].get()) {
       return obj(string("null"));
     }
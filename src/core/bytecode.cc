@@ -0,0 +1,524 @@
+#include <ff/bytecode.h>
+#include <ff/compiler/compiler.h>
+#include <ff/compiler/type_annotation.h>
+#include <ff/globals.h>
+#include <ff/errors.h>
+#include <ff/types.h>
+#include <mrt/strutils.h>
+#include <fstream>
+#include <cstring>
+
+static constexpr uint8_t kMagic[4] = {'F', 'F', 'C', '\0'};
+static constexpr uint16_t kOpcodeCount = ff::OP_HALT + 1;
+static constexpr uint8_t kNullAnnotation = 0xff;
+
+enum ConstantTag : uint8_t {
+  CTAG_INT,
+  CTAG_FLOAT,
+  CTAG_BOOL,
+  CTAG_STRING,
+  CTAG_FUNCTION,
+  CTAG_CLASS,
+  CTAG_MODULE,
+  CTAG_DICT,
+  CTAG_VECTOR,
+};
+
+static bool isGlobalOpcode(uint8_t op) {
+  return op == ff::OP_NEW_GLOBAL || op == ff::OP_GET_GLOBAL || op == ff::OP_SET_GLOBAL || op == ff::OP_SET_GLOBAL_REF;
+}
+
+/* Offset of the name operand (index in the code's symbols) from the start of operands, -1 if there is none */
+static int getSymbolOperandOffset(uint8_t op) {
+  switch (op) {
+    case ff::OP_GET_FIELD:
+    case ff::OP_SET_FIELD:
+    case ff::OP_SET_FIELD_REF:
+    case ff::OP_CALL_MEMBER:
+      return 0;
+    case ff::OP_GET_SLOT:
+    case ff::OP_SET_SLOT:
+      return sizeof(uint32_t);
+    default:
+      return -1;
+  }
+}
+
+namespace {
+
+class Writer {
+ private:
+  std::vector<uint8_t> m_data;
+
+ public:
+  std::vector<uint8_t>& data() {
+    return m_data;
+  }
+
+  void u8(uint8_t value) {
+    m_data.push_back(value);
+  }
+
+  void u16(uint16_t value) {
+    u8(value & 0xff);
+    u8(value >> 8);
+  }
+
+  void u64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      u8((value >> (i * 8)) & 0xff);
+    }
+  }
+
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      u8((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    u8(value);
+  }
+
+  void bytes(const uint8_t* data, size_t size) {
+    varint(size);
+    m_data.insert(m_data.end(), data, data + size);
+  }
+
+  void string(const std::string& value) {
+    bytes((const uint8_t*)value.data(), value.size());
+  }
+
+  void annotation(const ff::Ref<ff::TypeAnnotation>& type) {
+    if (!type.get()) {
+      u8(kNullAnnotation);
+      return;
+    }
+    u8(type->annotationType);
+    string(type->typeName);
+    u8((type->isInferred ? 1 : 0) | (type->isRef ? 2 : 0));
+    if (type->annotationType == ff::TypeAnnotation::TATYPE_FUNCTION) {
+      auto function = type.as<ff::FunctionAnnotation>();
+      varint(function->arguments.size());
+      for (auto& argument : function->arguments) {
+        annotation(argument);
+      }
+      annotation(function->returnType);
+    } else if (type->annotationType == ff::TypeAnnotation::TATYPE_UNION) {
+      auto union_ = type.as<ff::UnionAnnotation>();
+      varint(union_->types.size());
+      for (auto& member : union_->types) {
+        annotation(member);
+      }
+    }
+  }
+
+  void variable(const ff::Compiler::Variable& var) {
+    string(var.name);
+    annotation(var.type);
+    u8(var.isConst);
+    varint(var.fields.size());
+    for (auto& field : var.fields) {
+      string(field.first);
+      variable(field.second);
+    }
+  }
+
+  void code(const ff::Ref<ff::Code>& code) {
+    string(code->getFilename());
+
+    bytes(code->data(), code->size());
+
+    // Global slots are only valid in this process, so names are stored instead
+    varint(code->getGlobals().size());
+    for (uint32_t slot : code->getGlobals()) {
+      string(ff::globals::getName(slot));
+    }
+
+    // Symbols are interned again when the code is loaded
+    varint(code->getSymbols().size());
+    for (auto& symbol : code->getSymbols()) {
+      string(symbol.str());
+    }
+
+    auto& constants = code->getConstants();
+    varint(constants.size());
+    for (auto& constant : constants) {
+      this->constant(code, constant);
+    }
+
+    varint(code->getInlineCacheCount());
+    bytes(code->getLineTable().data(), code->getLineTable().size());
+
+    auto& modules = code->getModulePaths();
+    varint(modules.size());
+    for (auto& module : modules) {
+      string(module.first);
+      string(module.second);
+    }
+  }
+
+ private:
+  void constant(const ff::Ref<ff::Code>& owner, const ff::Ref<ff::Object>& constant) {
+    if (constant->isInstance()) {
+      switch (constant.as<ff::Instance>()->getTypeId()) {
+        case ff::TYPEID_INT:
+          u8(CTAG_INT);
+          u64(constant.as<ff::Int>()->value);
+          return;
+        case ff::TYPEID_FLOAT: {
+          uint64_t bits;
+          memcpy(&bits, &constant.as<ff::Float>()->value, sizeof(bits));
+          u8(CTAG_FLOAT);
+          u64(bits);
+          return;
+        }
+        case ff::TYPEID_BOOL:
+          u8(CTAG_BOOL);
+          u8(constant.as<ff::Bool>()->value);
+          return;
+        case ff::TYPEID_STRING:
+          u8(CTAG_STRING);
+          string(constant.as<ff::String>()->value);
+          return;
+        case ff::TYPEID_FUNCTION: {
+          auto function = constant.as<ff::Function>();
+          u8(CTAG_FUNCTION);
+          varint(function->args.size());
+          for (auto& arg : function->args) {
+            string(arg.name);
+            annotation(arg.type);
+          }
+          annotation(function->returnType);
+          code(function->code);
+          return;
+        }
+        case ff::TYPEID_CLASS:
+          if (constant.as<ff::Class>()->fieldInfo.empty()) {
+            u8(CTAG_CLASS);
+            string(constant.as<ff::Class>()->className);
+            return;
+          }
+          break;
+        case ff::TYPEID_MODULE:
+          u8(CTAG_MODULE);
+          string(constant.as<ff::Module>()->name);
+          return;
+        case ff::TYPEID_DICT:
+          u8(CTAG_DICT);
+          return;
+        case ff::TYPEID_VECTOR:
+          if (constant.as<ff::Vector>()->value.get().empty()) {
+            u8(CTAG_VECTOR);
+            return;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    throw ff::CompileError(owner->getFilename(), -1, "Cannot serialize constant '%s'", constant->toString().c_str());
+  }
+};
+
+class Reader {
+ private:
+  std::string m_filename;
+  const uint8_t* m_data;
+  size_t m_size;
+  size_t m_position = 0;
+  ff::Ref<ff::MappedFile> m_image; // If set, bytecode is used in place instead of being copied
+
+ public:
+  Reader(const std::string& filename, const uint8_t* data, size_t size, ff::Ref<ff::MappedFile> image)
+    : m_filename(filename), m_data(data), m_size(size), m_image(image) {}
+
+  void header() {
+    if (m_size < sizeof(kMagic) || memcmp(m_data, kMagic, sizeof(kMagic)) != 0) {
+      throw error("Not a bytecode file");
+    }
+    m_position += sizeof(kMagic);
+    uint16_t version = u16();
+    if (version != ff::bytecode::kFormatVersion) {
+      throw error("Unsupported bytecode version %u (expected %u)", version, ff::bytecode::kFormatVersion);
+    }
+    if (u16() != kOpcodeCount) {
+      throw error("Bytecode was produced by an incompatible version of ff");
+    }
+  }
+
+  ff::Ref<ff::Code> code() {
+    auto result = ff::memory::construct<ff::Code>(string());
+
+    size_t size = varint();
+    const uint8_t* bytecode = bytes(size);
+
+    size_t count = varint();
+    for (size_t i = 0; i < count; i++) {
+      result->addGlobal(ff::globals::getSlot(string()));
+    }
+
+    size_t symbolCount = varint();
+    for (size_t i = 0; i < symbolCount; i++) {
+      result->addSymbol(string());
+    }
+
+    // Check that operands don't point past the end of code, the global table or the symbol table
+    for (size_t i = 0; i < size; i += 1 + ff::getOperandSize((ff::Opcode)bytecode[i])) {
+      if (bytecode[i] >= kOpcodeCount || i + ff::getOperandSize((ff::Opcode)bytecode[i]) >= size) {
+        throw error("Malformed bytecode");
+      }
+      if (isGlobalOpcode(bytecode[i])) {
+        uint32_t global;
+        memcpy(&global, &bytecode[i + 1], sizeof(global));
+        if (global >= count) {
+          throw error("Malformed bytecode");
+        }
+      }
+      int symbolOffset = getSymbolOperandOffset(bytecode[i]);
+      if (symbolOffset >= 0) {
+        uint32_t symbol;
+        memcpy(&symbol, &bytecode[i + 1 + symbolOffset], sizeof(symbol));
+        if (symbol >= symbolCount) {
+          throw error("Malformed bytecode");
+        }
+      }
+    }
+    if (m_image.get()) {
+      result->setImage(m_image, bytecode, size);
+    } else {
+      result->append(bytecode, size);
+    }
+
+    count = varint();
+    for (size_t i = 0; i < count; i++) {
+      result->getConstants().push_back(constant());
+    }
+
+    count = varint();
+    for (size_t i = 0; i < count; i++) {
+      result->addInlineCache();
+    }
+
+    size = varint();
+    result->setLineTable(bytes(size), size);
+
+    count = varint();
+    for (size_t i = 0; i < count; i++) {
+      std::string name = string();
+      std::string path = string();
+      importModule(result, name, path);
+    }
+
+    return result;
+  }
+
+  ff::Compiler::Variable variable() {
+    ff::Compiler::Variable var;
+    var.name = string();
+    var.type = annotation();
+    var.isConst = u8() != 0;
+    size_t count = varint();
+    for (size_t i = 0; i < count; i++) {
+      std::string key = string();
+      var.fields[key] = variable();
+    }
+    return var;
+  }
+
+  size_t count() {
+    return varint();
+  }
+
+ private:
+  template <typename... Args>
+  ff::CompileError error(const char* fmt, Args... args) {
+    return ff::CompileError(m_filename, -1, fmt, args...);
+  }
+
+  const uint8_t* bytes(size_t size) {
+    if (size > m_size - m_position) {
+      throw error("Unexpected end of bytecode file");
+    }
+    const uint8_t* result = m_data + m_position;
+    m_position += size;
+    return result;
+  }
+
+  uint8_t u8() {
+    return *bytes(1);
+  }
+
+  uint16_t u16() {
+    const uint8_t* data = bytes(2);
+    return data[0] | (data[1] << 8);
+  }
+
+  uint64_t u64() {
+    const uint8_t* data = bytes(8);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+      value |= (uint64_t)data[i] << (i * 8);
+    }
+    return value;
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = u8();
+      value |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw error("Malformed varint");
+  }
+
+  std::string string() {
+    size_t size = varint();
+    return std::string((const char*)bytes(size), size);
+  }
+
+  ff::Ref<ff::TypeAnnotation> annotation() {
+    uint8_t type = u8();
+    if (type == kNullAnnotation) {
+      return ff::Ref<ff::TypeAnnotation>();
+    }
+    std::string typeName = string();
+    uint8_t flags = u8();
+    ff::Ref<ff::TypeAnnotation> result;
+    if (type == ff::TypeAnnotation::TATYPE_FUNCTION) {
+      std::vector<ff::Ref<ff::TypeAnnotation>> arguments(varint());
+      for (auto& argument : arguments) {
+        argument = annotation();
+      }
+      result = ff::FunctionAnnotation::create(arguments, annotation()).asRefTo<ff::TypeAnnotation>();
+    } else if (type == ff::TypeAnnotation::TATYPE_UNION) {
+      std::vector<ff::Ref<ff::TypeAnnotation>> types(varint());
+      for (auto& member : types) {
+        member = annotation();
+      }
+      result = ff::UnionAnnotation::create(types).asRefTo<ff::TypeAnnotation>();
+    } else if (type == ff::TypeAnnotation::TATYPE_DEFAULT) {
+      result = ff::TypeAnnotation::create();
+    } else {
+      throw error("Malformed type annotation");
+    }
+    result->typeName = typeName;
+    result->isInferred = flags & 1;
+    result->isRef = flags & 2;
+    return result;
+  }
+
+  ff::Ref<ff::Object> constant() {
+    switch (u8()) {
+      case CTAG_INT:
+        return ff::Int::createInstance((int64_t)u64()).asRefTo<ff::Object>();
+      case CTAG_FLOAT: {
+        uint64_t bits = u64();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return ff::Float::createInstance(value).asRefTo<ff::Object>();
+      }
+      case CTAG_BOOL:
+        return ff::Bool::createInstance(u8() != 0).asRefTo<ff::Object>();
+      case CTAG_STRING:
+        return ff::String::createInstance(string()).asRefTo<ff::Object>();
+      case CTAG_FUNCTION: {
+        std::vector<ff::Function::Argument> args(varint());
+        for (auto& arg : args) {
+          arg.name = string();
+          arg.type = annotation();
+        }
+        auto returnType = annotation();
+        return ff::Function::createInstance(code(), args, returnType).asRefTo<ff::Object>();
+      }
+      case CTAG_CLASS:
+        return ff::Class::createInstance(string()).asRefTo<ff::Object>();
+      case CTAG_MODULE:
+        return ff::Module::createInstance(string()).asRefTo<ff::Object>();
+      case CTAG_DICT:
+        return ff::Dict::createInstance({}).asRefTo<ff::Object>();
+      case CTAG_VECTOR:
+        return ff::Vector::createInstance({}).asRefTo<ff::Object>();
+      default:
+        throw error("Malformed constant");
+    }
+  }
+
+  /* Same as Compiler::import, but for an already resolved path */
+  void importModule(ff::Ref<ff::Code> code, const std::string& name, const std::string& path) {
+    ff::Compiler::ModuleInfo modInfo = ff::importModule(name, path, "");
+    code->addModule(name, modInfo.module.asRefTo<ff::Object>(), path);
+    for (auto& module : modInfo.imports) {
+      if (!code->hasModule(module.name)) {
+        code->addModule(module.name, module.module.asRefTo<ff::Object>());
+      }
+    }
+  }
+};
+
+} /* namespace */
+
+std::vector<uint8_t> ff::bytecode::serialize(Ref<Code> code) {
+  Writer writer;
+  writer.data().insert(writer.data().end(), kMagic, kMagic + sizeof(kMagic));
+  writer.u16(kFormatVersion);
+  writer.u16(kOpcodeCount);
+  writer.code(code);
+  return writer.data();
+}
+
+ff::Ref<ff::Code> ff::bytecode::deserialize(const std::string& filename, const uint8_t* data, size_t size) {
+  Reader reader(filename, data, size, {});
+  reader.header();
+  return reader.code();
+}
+
+std::vector<uint8_t> ff::bytecode::serializeModule(const ModuleImage& module) {
+  Writer writer;
+  writer.data().insert(writer.data().end(), kMagic, kMagic + sizeof(kMagic));
+  writer.u16(kFormatVersion);
+  writer.u16(kOpcodeCount);
+  writer.code(module.code);
+  writer.variable(module.var);
+  writer.varint(module.imports.size());
+  for (auto& import : module.imports) {
+    writer.variable(import);
+  }
+  return writer.data();
+}
+
+ff::bytecode::ModuleImage ff::bytecode::deserializeModule(const std::string& filename, const uint8_t* data, size_t size, Ref<MappedFile> image) {
+  Reader reader(filename, data, size, image);
+  reader.header();
+  ModuleImage result;
+  result.code = reader.code();
+  result.var = reader.variable();
+  result.imports.resize(reader.count());
+  for (auto& import : result.imports) {
+    import = reader.variable();
+  }
+  return result;
+}
+
+void ff::bytecode::save(Ref<Code> code, const std::string& filename) {
+  auto data = serialize(code);
+  std::ofstream file(filename, std::ios::binary);
+  if (!file || !file.write((const char*)data.data(), data.size())) {
+    throw CompileError(filename, -1, "Error writing file");
+  }
+}
+
+ff::Ref<ff::Code> ff::bytecode::load(const std::string& filename) {
+  auto image = MappedFile::open(filename);
+  if (!image.get()) {
+    throw CompileError(filename, -1, "Error opening file");
+  }
+  Reader reader(filename, image->data(), image->size(), image);
+  reader.header();
+  return reader.code();
+}
+
+bool ff::bytecode::isBytecodeFile(const std::string& filename) {
+  return mrt::str::endsWith(filename, kExtension);
+}
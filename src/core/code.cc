@@ -1,4 +1,7 @@
 #include <ff/code.h>
+#include <ff/globals.h>
+#include <ff/types.h>
+#include <functional>
 #include <algorithm>
 #include <cstdio>
 
@@ -21,9 +24,12 @@ std::string ff::opcodeToString(const Opcode op) {
     case OP_GET_LOCAL:      return "OP_GET_LOCAL";
     case OP_SET_LOCAL:      return "OP_SET_LOCAL";
     case OP_SET_LOCAL_REF:  return "OP_SET_LOCAL_REF";
+    case OP_REF_LOCAL:      return "OP_REF_LOCAL";
     case OP_GET_FIELD:      return "OP_GET_FIELD";
     case OP_SET_FIELD:      return "OP_SET_FIELD";
     case OP_SET_FIELD_REF:  return "OP_SET_FIELD_REF";
+    case OP_GET_SLOT:       return "OP_GET_SLOT";
+    case OP_SET_SLOT:       return "OP_SET_SLOT";
     case OP_GET_STATIC:     return "OP_GET_STATIC";
     case OP_JUMP:           return "OP_JUMP";
     case OP_JUMP_TRUE:      return "OP_JUMP_TRUE";
@@ -31,6 +37,7 @@ std::string ff::opcodeToString(const Opcode op) {
     case OP_LOOP:           return "OP_LOOP";
     case OP_CALL:           return "OP_CALL";
     case OP_CALL_MEMBER:    return "OP_CALL_MEMBER";
+    case OP_TAIL_CALL:      return "OP_TAIL_CALL";
     case OP_RETURN:         return "OP_RETURN";
     case OP_CAST:           return "OP_CAST";
     case OP_PRINT:          return "OP_PRINT";
@@ -51,38 +58,159 @@ std::string ff::opcodeToString(const Opcode op) {
     case OP_NEG:            return "OP_NEG";
     case OP_INC:            return "OP_INC";
     case OP_DEC:            return "OP_DEC";
+    case OP_INC_LOCAL:      return "OP_INC_LOCAL";
+    case OP_DEC_LOCAL:      return "OP_DEC_LOCAL";
     case OP_BREAKPOINT:     return "OP_BREAKPOINT";
+    case OP_HALT:           return "OP_HALT";
     default:                return "?";
   }
 }
 
+size_t ff::getOperandSize(const Opcode op) {
+  switch (op) {
+    case OP_PULL_UP:
+    case OP_JUMP:
+    case OP_JUMP_TRUE:
+    case OP_JUMP_FALSE:
+    case OP_LOOP:
+      return sizeof(uint16_t);
+    case OP_LOAD_CONSTANT:
+    case OP_NEW_GLOBAL:
+    case OP_GET_GLOBAL:
+    case OP_SET_GLOBAL:
+    case OP_SET_GLOBAL_REF:
+    case OP_SET_FIELD:
+    case OP_SET_FIELD_REF:
+    case OP_GET_LOCAL:
+    case OP_SET_LOCAL:
+    case OP_SET_LOCAL_REF:
+    case OP_REF_LOCAL:
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
+      return sizeof(uint32_t);
+    case OP_GET_FIELD:
+    case OP_CALL_MEMBER:
+      return sizeof(uint32_t) * 2;
+    case OP_GET_SLOT:
+    case OP_SET_SLOT:
+      return sizeof(uint32_t) * 3;
+    default:
+      return 0;
+  }
+}
+
 ff::Code::Code(const std::string& filename) : m_filename(filename) {}
 
-size_t ff::Code::size() const {
-  return m_code.size();
+void ff::Code::append(const uint8_t* data, size_t size) {
+  m_code.insert(m_code.end(), data, data + size);
+}
+
+void ff::Code::setImage(Ref<MappedFile> file, const uint8_t* data, size_t size) {
+  m_code.clear();
+  m_imageFile = file;
+  m_image = data;
+  m_imageSize = size;
 }
 
 ff::Ref<ff::Object> ff::Code::getConstant(unsigned index) {
   return m_constants[index];
 }
 
+/* Hash that is equal for constants that are equal()
+ * Values of int/float/bool/string and functions are hashed, other objects are hashed only by their type
+ * (they are still deduplicated by equals(), but only among constants of the same type)
+ */
+static size_t hashConstant(const ff::Ref<ff::Object>& constant) {
+  const ff::Object* object = constant.get();
+  if (!object->isInstance()) {
+    return std::hash<int>()(object->getObjectType());
+  }
+  ff::TypeId typeId = ((const ff::Instance*)object)->getTypeId();
+  size_t hash = 0;
+  switch (typeId) {
+    case ff::TYPEID_INT:      hash = std::hash<ff::Int::ValueType>()(((const ff::Int*)object)->value); break;
+    case ff::TYPEID_FLOAT:    hash = std::hash<ff::Float::ValueType>()(((const ff::Float*)object)->value); break;
+    case ff::TYPEID_BOOL:     hash = std::hash<bool>()(((const ff::Bool*)object)->value); break;
+    case ff::TYPEID_STRING:   hash = std::hash<std::string>()(((const ff::String*)object)->value); break;
+    case ff::TYPEID_FUNCTION: hash = std::hash<const void*>()(((const ff::Function*)object)->code.get()); break;
+    default: break;
+  }
+  return hash ^ (std::hash<ff::TypeId>()(typeId) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+}
+
 unsigned ff::Code::addConstant(Ref<Object> constant) {
-  auto itr = std::find_if(m_constants.begin(), m_constants.end(), [&constant](Ref<Object> other) {
-    return constant->equals(other);
-  });
-  if (itr == m_constants.end()) {
+  size_t hash = hashConstant(constant);
+  // Same result as scanning all constants for the first one that is equal
+  unsigned index = m_constants.size();
+  auto range = m_constantIndex.equal_range(hash);
+  for (auto itr = range.first; itr != range.second; itr++) {
+    if (itr->second < index && constant->equals(m_constants[itr->second])) {
+      index = itr->second;
+    }
+  }
+  if (index == m_constants.size()) {
     m_constants.push_back(constant);
-    return m_constants.size() - 1;
+    m_constantIndex.emplace(hash, index);
   }
-  return itr - m_constants.begin();
+  return index;
 }
 
 std::vector<ff::Ref<ff::Object>>& ff::Code::getConstants() {
   return m_constants;
 }
 
-void ff::Code::addModule(const std::string& name, Ref<Object> module) {
+uint32_t ff::Code::addGlobal(uint32_t slot) {
+  auto itr = m_globalIndex.find(slot);
+  if (itr != m_globalIndex.end()) {
+    return itr->second;
+  }
+  uint32_t index = m_globals.size();
+  m_globals.push_back(slot);
+  m_globalIndex[slot] = index;
+  return index;
+}
+
+const std::vector<uint32_t>& ff::Code::getGlobals() const {
+  return m_globals;
+}
+
+uint32_t ff::Code::addSymbol(const Symbol& symbol) {
+  auto itr = m_symbolIndex.find(symbol);
+  if (itr != m_symbolIndex.end()) {
+    return itr->second;
+  }
+  uint32_t index = m_symbols.size();
+  m_symbols.push_back(symbol);
+  m_symbolIndex[symbol] = index;
+  return index;
+}
+
+const ff::Symbol& ff::Code::getSymbol(uint32_t index) const {
+  return m_symbols[index];
+}
+
+const std::vector<ff::Symbol>& ff::Code::getSymbols() const {
+  return m_symbols;
+}
+
+uint32_t ff::Code::addInlineCache() {
+  m_inlineCaches.emplace_back();
+  return m_inlineCaches.size() - 1;
+}
+
+size_t ff::Code::getInlineCacheCount() const {
+  return m_inlineCaches.size();
+}
+
+ff::InlineCache& ff::Code::getInlineCache(uint32_t index) {
+  return m_inlineCaches[index];
+}
+
+void ff::Code::addModule(const std::string& name, Ref<Object> module, const std::string& path) {
   m_modules[name] = module;
+  if (!path.empty()) {
+    m_modulePaths[name] = path;
+  }
 }
 
 bool ff::Code::hasModule(const std::string& name) {
@@ -97,16 +225,20 @@ std::map<std::string, ff::Ref<ff::Object>>& ff::Code::getModules() {
   return m_modules;
 }
 
+const std::map<std::string, std::string>& ff::Code::getModulePaths() const {
+  return m_modulePaths;
+}
+
 uint8_t& ff::Code::operator [](unsigned index) {
   return m_code[index];
 }
 
 uint8_t ff::Code::operator [](unsigned index) const {
-  return m_code[index];
+  return data()[index];
 }
 
 bool ff::Code::canRead() const {
-  return m_readIndex < m_code.size();
+  return m_readIndex < size();
 }
 
 void ff::Code::resetRead() {
@@ -125,34 +257,103 @@ std::string ff::Code::getFilename() const {
   return m_filename;
 }
 
-int ff::Code::getLine(unsigned offset) const {
-  for (int i = 0; i < m_lines.size(); i++) {
-    if (m_lines[i].startOffset == offset) {return m_lines[i].line;
-    } else if (m_lines[i].startOffset < offset) {
-      if (i+1 == m_lines.size()) {
-        return m_lines[i].line;
-      }
-    } else {return m_lines[i-1].line;
+static void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+static uint32_t readVarint(const uint8_t* data, size_t& position) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t byte = data[position++];
+    value |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return value;
     }
   }
+}
 
-  return 0;
+static inline uint32_t zigzagEncode(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
 }
 
-void ff::Code::pushInstruction(uint8_t op, int line) {
-  m_code.push_back(op);
+static inline int32_t zigzagDecode(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+int ff::Code::getLine(unsigned offset) const {
+  auto itr = std::upper_bound(m_lineCheckpoints.begin(), m_lineCheckpoints.end(), offset,
+    [](unsigned offset, const LineCheckpoint& checkpoint) {
+      return offset < checkpoint.offset;
+    });
+  if (itr == m_lineCheckpoints.begin()) {
+    return 0;
+  }
+  --itr;
 
-  if (line == -1) // Means the same line as the instruction before
+  uint32_t lineOffset = itr->offset;
+  int32_t line = itr->line;
+  size_t position = itr->position;
+  while (position < m_lineTable.size()) {
+    uint32_t nextOffset = lineOffset + readVarint(m_lineTable.data(), position);
+    int32_t nextLine = line + zigzagDecode(readVarint(m_lineTable.data(), position));
+    if (nextOffset > offset) {
+      break;
+    }
+    lineOffset = nextOffset;
+    line = nextLine;
+  }
+  return line;
+}
+
+void ff::Code::setLine(int line) {
+  if (line < 0 || (m_lineCount && line == m_lastLine)) {
     return;
-  if (m_lines.size() == 0) {
-    m_lines.push_back({m_code.size()-1, line});
-  } else {
-    if (m_lines[m_lines.size()-1].line != line) {
-      m_lines.push_back({m_code.size()-1, line});
+  }
+  uint32_t offset = m_code.size();
+  writeVarint(m_lineTable, offset - m_lastLineOffset);
+  writeVarint(m_lineTable, zigzagEncode(line - m_lastLine));
+  if (m_lineCount++ % kLineCheckpointInterval == 0) {
+    m_lineCheckpoints.push_back({offset, line, (uint32_t)m_lineTable.size()});
+  }
+  m_lastLineOffset = offset;
+  m_lastLine = line;
+}
+
+size_t ff::Code::getLineTableSize() const {
+  return m_lineTable.size() + m_lineCheckpoints.size() * sizeof(LineCheckpoint);
+}
+
+const std::vector<uint8_t>& ff::Code::getLineTable() const {
+  return m_lineTable;
+}
+
+void ff::Code::setLineTable(const uint8_t* data, size_t size) {
+  m_lineTable.assign(data, data + size);
+  m_lineCheckpoints.clear();
+  m_lineCount = 0;
+  m_lastLineOffset = 0;
+  m_lastLine = 0;
+  size_t position = 0;
+  while (position < m_lineTable.size()) {
+    m_lastLineOffset += readVarint(m_lineTable.data(), position);
+    m_lastLine += zigzagDecode(readVarint(m_lineTable.data(), position));
+    if (m_lineCount++ % kLineCheckpointInterval == 0) {
+      m_lineCheckpoints.push_back({m_lastLineOffset, m_lastLine, (uint32_t)position});
     }
   }
 }
 
+void ff::Code::pushInstruction(uint8_t op, int line) {
+  if (line != -1) { // -1 means the same line as the instruction before
+    setLine(line);
+  }
+  m_code.push_back(op);
+}
+
 void ff::Code::disassemble(const std::string& prefix) {
   resetRead();
   while (canRead()) {
@@ -170,6 +371,35 @@ void ff::Code::disassembleInstruction(const std::string& prefix) {
     case OP_LOAD_CONSTANT:
       printf(" %u\n", read<uint32_t>());
       return;
+    case OP_GET_FIELD:
+    case OP_CALL_MEMBER: {
+      uint32_t name = read<uint32_t>();
+      uint32_t cache = read<uint32_t>();
+      printf(" %u (%s) ic=%u\n", name, m_symbols[name].c_str(), cache);
+      return;
+    }
+    case OP_GET_SLOT:
+    case OP_SET_SLOT: {
+      uint32_t slot = read<uint32_t>();
+      uint32_t name = read<uint32_t>();
+      uint32_t cache = read<uint32_t>();
+      printf(" %u %u (%s) ic=%u\n", slot, name, m_symbols[name].c_str(), cache);
+      return;
+    }
+    case OP_SET_FIELD:
+    case OP_SET_FIELD_REF: {
+      uint32_t name = read<uint32_t>();
+      printf(" %u (%s)\n", name, m_symbols[name].c_str());
+      return;
+    }
+    case OP_NEW_GLOBAL:
+    case OP_GET_GLOBAL:
+    case OP_SET_GLOBAL:
+    case OP_SET_GLOBAL_REF: {
+      uint32_t global = read<uint32_t>();
+      printf(" %u (%s)\n", global, globals::getName(m_globals[global]).c_str());
+      return;
+    }
     case OP_GET_LOCAL:
       printf(" %u\n", read<uint32_t>());
       return;
@@ -177,6 +407,9 @@ void ff::Code::disassembleInstruction(const std::string& prefix) {
       printf(" %u\n",read<uint32_t>());
       return;
     case OP_SET_LOCAL_REF:
+    case OP_REF_LOCAL:
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
       printf(" %u\n",read<uint32_t>());
       return;
     case OP_JUMP:
@@ -2,21 +2,39 @@
 #include <ff/log.h>
 #include <mrt/container_utils.h>
 #include <cstdlib>
+#include <thread>
+#include <mutex>
 
 static std::map<std::string, std::string> g_values;
+static std::mutex g_mutex; // Imports are parsed on worker threads, which read config
 
 void ff::config::initialize() {
   set("entry", "main");
   set("debug", "0");
   set("verbose", "0");
   set("import_path", "");
+  set("stack_size", "65536");
+  set("call_depth", "16384");
+  set("copy_elision", "1"); // Compiler drops copies that can't be observed (see Compiler::evalNode)
+  set("copy_stats", "0");
+
+  // Threads that parse imported modules ahead of compilation (importing thread compiles meanwhile), 0 parses them on demand
+  unsigned cores = std::thread::hardware_concurrency();
+  set("import_threads", std::to_string(cores > 1 ? cores - 1 : 0));
+
+  // Compiled imported modules are cached here (see ff/module_cache.h), empty value disables the cache
+  const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+  const char* home = std::getenv("HOME");
+  set("cache_dir", cacheHome ? std::string(cacheHome) + "/ff" : home ? std::string(home) + "/.cache/ff" : "");
 }
 
 bool ff::config::exists(const std::string& key) {
+  std::lock_guard<std::mutex> lock(g_mutex);
   return g_values.find(key) != g_values.end();
 }
 
 std::string ff::config::get(const std::string& key) {
+  std::lock_guard<std::mutex> lock(g_mutex);
   return g_values.at(key);
 }
 
@@ -25,6 +43,7 @@ std::string ff::config::getOr(const std::string& key, const std::string& default
 }
 
 void ff::config::set(const std::string& key, const std::string& value) {
+  std::lock_guard<std::mutex> lock(g_mutex);
   g_values[key] = value;
 }
 
@@ -33,6 +52,7 @@ std::map<std::string, std::string>& ff::config::getAll() {
 }
 
 std::vector<std::string> ff::config::getKeys() {
+  std::lock_guard<std::mutex> lock(g_mutex);
   return mrt::reduce<std::vector<std::string>>(g_values, [](auto keys, auto pair) {
     keys.push_back(pair.first);
     return keys;
@@ -0,0 +1,40 @@
+#include <ff/globals.h>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+
+static std::mutex g_mutex; // Isolates compile and load code concurrently
+static std::unordered_map<std::string, uint32_t> g_slots;
+static std::deque<std::string> g_names; // Deque, so references returned by getName stay valid
+
+uint32_t ff::globals::getSlot(const std::string& name) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto itr = g_slots.find(name);
+  if (itr != g_slots.end()) {
+    return itr->second;
+  }
+  uint32_t slot = g_names.size();
+  g_names.push_back(name);
+  g_slots[name] = slot;
+  return slot;
+}
+
+bool ff::globals::findSlot(const std::string& name, uint32_t& slot) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto itr = g_slots.find(name);
+  if (itr == g_slots.end()) {
+    return false;
+  }
+  slot = itr->second;
+  return true;
+}
+
+const std::string& ff::globals::getName(uint32_t slot) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_names.at(slot);
+}
+
+uint32_t ff::globals::count() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_names.size();
+}
@@ -0,0 +1,107 @@
+#include <ff/isolate.h>
+#include <ff/builtins.h>
+#include <ff/types.h>
+
+void ff::makeImmortal(Ref<TypeAnnotation> annotation) {
+  if (!annotation.get() || annotation->isImmortal()) {
+    return;
+  }
+  annotation->makeImmortal();
+
+  if (annotation->annotationType == TypeAnnotation::TATYPE_FUNCTION) {
+    auto function = annotation.as<FunctionAnnotation>();
+    for (auto& argument : function->arguments) {
+      makeImmortal(argument);
+    }
+    makeImmortal(function->returnType);
+  } else if (annotation->annotationType == TypeAnnotation::TATYPE_UNION) {
+    for (auto& type : annotation.as<UnionAnnotation>()->types) {
+      makeImmortal(type);
+    }
+  }
+}
+
+void ff::makeImmortal(Ref<Object> object) {
+  if (!object.get() || object->isImmortal()) {
+    return;
+  }
+  // Marked before visiting anything, so reference cycles terminate
+  object->makeImmortal();
+  object->makeFieldsImmortal();
+
+  // Dict elements and module members are fields too
+  for (auto& field : object.as<const Object>()->getFields()) {
+    makeImmortal(field.second);
+  }
+
+  if (!object->isInstance()) {
+    return;
+  }
+
+  makeImmortal(object.as<Instance>()->getType().asRefTo<Object>());
+
+  switch (object.as<Instance>()->getTypeId()) {
+    case TYPEID_FUNCTION: {
+      auto function = object.as<Function>();
+      for (auto& argument : function->args) {
+        makeImmortal(argument.type);
+      }
+      makeImmortal(function->returnType);
+      break;
+    }
+    case TYPEID_NATIVE_FUNCTION: {
+      auto function = object.as<NativeFunction>();
+      for (auto& argument : function->args) {
+        makeImmortal(argument.type);
+      }
+      makeImmortal(function->returnType);
+      break;
+    }
+    case TYPEID_CLASS:
+      for (auto& field : object.as<Class>()->fieldInfo) {
+        makeImmortal(field.second.initialValue);
+      }
+      break;
+    case TYPEID_CLASS_INSTANCE: {
+      auto instance = object.as<ClassInstance>();
+      makeImmortal(instance->getClass().asRefTo<Object>());
+      for (size_t i = 0; i < instance->getSlotCount(); i++) {
+        makeImmortal(instance->getSlot(i));
+      }
+      break;
+    }
+    case TYPEID_VECTOR:
+      object.as<Vector>()->value.makeImmortal();
+      for (auto& element : object.as<Vector>()->value.get()) {
+        makeImmortal(element);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void ff::initialize() {
+  makeImmortal(TypeAnnotation::any());
+  makeImmortal(TypeAnnotation::nothing());
+  makeImmortal(TypeAnnotation::type());
+
+  makeImmortal(IntType::getInstance().asRefTo<Object>());
+  makeImmortal(FloatType::getInstance().asRefTo<Object>());
+  makeImmortal(BoolType::getInstance().asRefTo<Object>());
+  makeImmortal(StringType::getInstance().asRefTo<Object>());
+  makeImmortal(FunctionType::getInstance().asRefTo<Object>());
+  makeImmortal(NativeFunctionType::getInstance().asRefTo<Object>());
+  makeImmortal(ModuleType::getInstance().asRefTo<Object>());
+  makeImmortal(DictType::getInstance().asRefTo<Object>());
+  makeImmortal(VectorType::getInstance().asRefTo<Object>());
+  makeImmortal(ClassType::getInstance().asRefTo<Object>());
+  makeImmortal(ClassInstanceType::getInstance().asRefTo<Object>());
+  makeImmortal(CPtrType::getInstance().asRefTo<Object>());
+
+  makeImmortal(fn_exit.asRefTo<Object>());
+  makeImmortal(fn_assert.asRefTo<Object>());
+  makeImmortal(fn_type.asRefTo<Object>());
+  makeImmortal(fn_inspect.asRefTo<Object>());
+  makeImmortal(fn_memaddr.asRefTo<Object>());
+}
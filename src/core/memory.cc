@@ -0,0 +1,176 @@
+#include <ff/memory.h>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _FF_MEMORY_DEBUG
+#include <iostream>
+#endif
+
+using namespace ff::memory::pool;
+
+static constexpr size_t kChunkSize = 64 * 1024;
+static constexpr size_t kLargeClass = kSizeClassCount;
+
+struct ChunkHeader {
+  size_t sizeClass;
+  size_t size; // Only used by large allocations
+};
+
+static constexpr size_t kHeaderSize = (sizeof(ChunkHeader) + kGranularity - 1) / kGranularity * kGranularity;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// Per thread, so threads that parse imports don't need to lock. Blocks are returned to the list of the freeing thread
+static thread_local FreeBlock* g_freeLists[kSizeClassCount] = {};
+
+#ifdef _FF_MEMORY_DEBUG
+static SizeClassStats g_stats[kSizeClassCount + 1] = {};
+
+static void recordAllocation(size_t sizeClass) {
+  static bool registered = false;
+  if (!registered) {
+    registered = true;
+    atexit(printStats);
+  }
+  SizeClassStats& stats = g_stats[sizeClass];
+  stats.total++;
+  if (++stats.live > stats.peak) {
+    stats.peak = stats.live;
+  }
+}
+
+static void recordFree(size_t sizeClass) {
+  g_stats[sizeClass].live--;
+}
+#endif
+
+static inline size_t getSizeClass(size_t size) {
+  return size ? (size - 1) / kGranularity : 0;
+}
+
+static inline size_t getBlockSize(size_t sizeClass) {
+  return (sizeClass + 1) * kGranularity;
+}
+
+static inline ChunkHeader* getChunk(void* ptr) {
+  return (ChunkHeader*)((uintptr_t)ptr & ~(uintptr_t)(kChunkSize - 1));
+}
+
+static void* allocateChunk(size_t size) {
+  void* chunk = nullptr;
+  if (posix_memalign(&chunk, kChunkSize, size) != 0) {
+    // TODO ERROR Allocation Failed
+    exit(-1);
+  }
+  return chunk;
+}
+
+static void refill(size_t sizeClass) {
+  ChunkHeader* chunk = (ChunkHeader*)allocateChunk(kChunkSize);
+  chunk->sizeClass = sizeClass;
+  chunk->size = kChunkSize;
+
+  const size_t blockSize = getBlockSize(sizeClass);
+  const size_t blockCount = (kChunkSize - kHeaderSize) / blockSize;
+  uint8_t* begin = (uint8_t*)chunk + kHeaderSize;
+
+  FreeBlock* head = g_freeLists[sizeClass];
+  for (size_t i = blockCount; i-- > 0;) {
+    FreeBlock* block = (FreeBlock*)(begin + i * blockSize);
+    block->next = head;
+    head = block;
+  }
+  g_freeLists[sizeClass] = head;
+}
+
+static size_t getCapacity(void* ptr) {
+  ChunkHeader* chunk = getChunk(ptr);
+  return chunk->sizeClass == kLargeClass ? chunk->size : getBlockSize(chunk->sizeClass);
+}
+
+void* ff::memory::pool::allocate(size_t size) {
+  if (size > kMaxBlockSize) {
+    ChunkHeader* chunk = (ChunkHeader*)allocateChunk(kHeaderSize + size);
+    chunk->sizeClass = kLargeClass;
+    chunk->size = size;
+#ifdef _FF_MEMORY_DEBUG
+    recordAllocation(kLargeClass);
+#endif
+    return (uint8_t*)chunk + kHeaderSize;
+  }
+
+  size_t sizeClass = getSizeClass(size);
+  if (!g_freeLists[sizeClass]) {
+    refill(sizeClass);
+  }
+
+  FreeBlock* block = g_freeLists[sizeClass];
+  g_freeLists[sizeClass] = block->next;
+#ifdef _FF_MEMORY_DEBUG
+  recordAllocation(sizeClass);
+#endif
+  return block;
+}
+
+void* ff::memory::pool::reallocate(void* ptr, size_t size) {
+  if (!ptr) {
+    return allocate(size);
+  }
+
+  size_t capacity = getCapacity(ptr);
+  if (size <= capacity && (size > kMaxBlockSize || getSizeClass(size) == getChunk(ptr)->sizeClass)) {
+    return ptr;
+  }
+
+  void* result = allocate(size);
+  memcpy(result, ptr, size < capacity ? size : capacity);
+  free(ptr);
+  return result;
+}
+
+void ff::memory::pool::free(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  ChunkHeader* chunk = getChunk(ptr);
+#ifdef _FF_MEMORY_DEBUG
+  recordFree(chunk->sizeClass);
+#endif
+
+  if (chunk->sizeClass == kLargeClass) {
+    ::free(chunk);
+    return;
+  }
+
+  FreeBlock* block = (FreeBlock*)ptr;
+  block->next = g_freeLists[chunk->sizeClass];
+  g_freeLists[chunk->sizeClass] = block;
+}
+
+#ifdef _FF_MEMORY_DEBUG
+ff::memory::pool::SizeClassStats ff::memory::pool::getStats(size_t sizeClass) {
+  SizeClassStats stats = g_stats[sizeClass];
+  stats.blockSize = sizeClass == kLargeClass ? 0 : getBlockSize(sizeClass);
+  return stats;
+}
+
+void ff::memory::pool::printStats() {
+  std::cout << "memory::pool stats:" << std::endl;
+  for (size_t i = 0; i <= kSizeClassCount; i++) {
+    SizeClassStats stats = getStats(i);
+    if (!stats.total) {
+      continue;
+    }
+    std::cout << "  size=";
+    if (stats.blockSize) {
+      std::cout << stats.blockSize;
+    } else {
+      std::cout << ">" << kMaxBlockSize;
+    }
+    std::cout << " live=" << stats.live << " peak=" << stats.peak << " total=" << stats.total << std::endl;
+  }
+}
+#endif
@@ -4,21 +4,185 @@
 #include <ff/compiler/compiler.h>
 #include <ff/compiler/type_annotation.h>
 #include <ff/utils/dynamic_library_manager.h>
+#include <ff/utils/thread_pool.h>
+#include <ff/utils/path.h>
+#include <ff/compiler/scanner.h>
+#include <ff/compiler/parser.h>
+#include <ff/module_cache.h>
+#include <ff/isolate.h>
+#include <ff/config.h>
 #include <mrt/dynamic_library.h>
+#include <mrt/strutils.h>
+#include <unordered_map>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <map>
 
-ff::Compiler::ModuleInfo ff::loadNativeModule(const std::string& name, const std::string& filename) {
-  Ref<Module> module = Module::createInstance(name);
+namespace {
+
+struct RegistryEntry {
+  ff::Compiler::ModuleInfo info;
+  bool isLoaded = false; // Entry is added before loading, so importing it again before that is a circular import
+};
+
+struct ParsedModule {
+  std::string src;
+  ff::ast::Node* tree = nullptr;
+};
+
+/* Modules of one isolate, prefetch jobs it started keep it alive while they run */
+struct Registry {
+  std::map<std::string, RegistryEntry> modules; // Canonical path -> module
+  std::map<std::string, std::shared_future<ParsedModule>> prefetched; // Canonical path -> parse result
+};
+
+/* Loaded modules are objects of the isolate, so they are released on its thread when it exits */
+struct IsolateRegistry {
+  std::shared_ptr<Registry> registry = std::make_shared<Registry>();
+
+  ~IsolateRegistry();
+};
+
+} /* namespace */
+
+static std::mutex g_mutex; // Guards everything below and all registries, imports are discovered on worker threads too
+static std::unordered_map<std::string, std::string> g_resolvedImports; // Import and search paths -> file
+static thread_local IsolateRegistry g_registry;
+
+IsolateRegistry::~IsolateRegistry() {
+  std::map<std::string, RegistryEntry> modules;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    modules.swap(registry->modules);
+  }
+}
+
+static bool isNativeModule(const std::string& filename) {
+  return mrt::str::endsWith(filename, ".ffmod") || mrt::str::endsWith(filename, ".so");
+}
+
+static ff::ThreadPool& getThreadPool() {
+  // Constructed on first use, after the statics above, so its threads are joined before those are destroyed
+  static ff::ThreadPool pool(std::stoul(ff::config::get("import_threads")));
+  return pool;
+}
+
+static void collectImports(ff::ast::Node* node, std::vector<std::string>& imports) {
+  if (!node) {
+    return;
+  }
+  switch (node->getType()) {
+    case ff::ast::NTYPE_BLOCK:
+      for (auto child : node->as<ff::ast::Block>()->getBody()) {
+        collectImports(child, imports);
+      }
+      break;
+    case ff::ast::NTYPE_MODULE:
+      collectImports(node->as<ff::ast::Module>()->getBody(), imports);
+      break;
+    case ff::ast::NTYPE_IMPORT:
+      for (auto& import : node->as<ff::ast::Import>()->getImports()) {
+        imports.push_back(import);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static ParsedModule parseModule(const std::string& filename) {
+  std::ifstream sourceFile(filename);
+  if (!sourceFile) {
+    throw ff::CompileError(filename, -1, "Error opening file");
+  }
+
+  ParsedModule result;
+  result.src = std::string((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+
+  ff::Scanner scanner(filename, result.src);
+  auto tokens = scanner.tokenize();
+
+  ff::Parser parser(filename, tokens);
+  result.tree = parser.parse();
+
+  return result;
+}
+
+static void prefetchImports(const std::shared_ptr<Registry>& registry, const std::string& filename, ff::ast::Node* tree);
+
+static void prefetchModule(const std::shared_ptr<Registry>& registry, const std::string& filename) {
+  std::string canonicalPath = ff::path::getCanonicalPath(filename);
+  auto isKnown = [&registry, &canonicalPath]() {
+    return registry->modules.find(canonicalPath) != registry->modules.end()
+        || registry->prefetched.find(canonicalPath) != registry->prefetched.end();
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (isKnown()) {
+      return;
+    }
+  }
+
+  // Cached modules are loaded without parsing, so are their imports (entry is invalidated when those change)
+  if (ff::cache::isEnabled() && ff::cache::isValid(filename)) {
+    return;
+  }
+
+  auto promise = std::make_shared<std::promise<ParsedModule>>();
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (isKnown()) {
+      return;
+    }
+    registry->prefetched[canonicalPath] = promise->get_future().share();
+  }
+
+  getThreadPool().submit([registry, filename, promise]() {
+    try {
+      ParsedModule result = parseModule(filename);
+      // Imports are discovered before the tree is handed over, after that it belongs to the importer
+      prefetchImports(registry, filename, result.tree);
+      promise->set_value(result);
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+}
 
-  bool libAlreadyLoaded = DynamicLibraryManager::libraryExists(name);
+static ff_modinfo_t* loadLibrary(const std::string& name, const std::string& filename) {
+  // Held until symbols are immortal, so another isolate can't see the library before that
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
 
-  auto lib = libAlreadyLoaded ? DynamicLibraryManager::getLibrary(name) : Ref(new mrt::DynamicLibrary(filename));
+  bool libAlreadyLoaded = ff::DynamicLibraryManager::libraryExists(name);
+
+  auto lib = libAlreadyLoaded ? ff::DynamicLibraryManager::getLibrary(name) : std::make_shared<mrt::DynamicLibrary>(filename);
 
   ff_modinfo_t* modInfo = lib->getSymbolAs<ff_modinfo_t*>(FF_MODINFO_STR);
 
   if (!modInfo) {
-    throw CompileError(filename, -1, "Cannot find module info symbol ('%s') in module %s", FF_MODINFO_STR, name.c_str());
+    throw ff::CompileError(filename, -1, "Cannot find module info symbol ('%s') in module %s", FF_MODINFO_STR, name.c_str());
   }
 
+  if (!libAlreadyLoaded) {
+    // Symbols are static objects of the library, so every isolate that imports it shares them
+    for (int i = 0; modInfo->symbols[i].name; i++) {
+      ff::makeImmortal(modInfo->symbols[i].symbol);
+    }
+    ff::DynamicLibraryManager::setLibrary(name, lib);
+  }
+
+  return modInfo;
+}
+
+ff::Compiler::ModuleInfo ff::loadNativeModule(const std::string& name, const std::string& filename) {
+  Ref<Module> module = Module::createInstance(name);
+
+  ff_modinfo_t* modInfo = loadLibrary(name, filename);
+
   module->setField("__author__", String::createInstance(modInfo->author).asRefTo<Object>());
   module->setField("__version__", String::createInstance(modInfo->version).asRefTo<Object>());
 
@@ -33,9 +197,105 @@ ff::Compiler::ModuleInfo ff::loadNativeModule(const std::string& name, const std
     {},
   };
 
-  if (!libAlreadyLoaded) {
-    DynamicLibraryManager::setLibrary(name, lib);
+  return result;
+}
+
+ff::Compiler::ModuleInfo ff::importModule(const std::string& name, const std::string& filename, const std::string& parentModule) {
+  std::string canonicalPath = path::getCanonicalPath(filename);
+  auto& modules = g_registry.registry->modules;
+
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto itr = modules.find(canonicalPath);
+    if (itr != modules.end()) {
+      if (!itr->second.isLoaded) {
+        throw CompileError(filename, -1, "Circular import detected (module '%s' from module '%s')", name.c_str(), parentModule.empty() ? "<no name>" : parentModule.c_str());
+      }
+      return itr->second.info;
+    }
+    modules[canonicalPath] = {};
   }
 
+  Compiler::ModuleInfo result;
+  try {
+    if (isNativeModule(filename)) {
+      result = loadNativeModule(name, filename);
+    } else {
+      result = loadModule(name, filename, parentModule);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    modules.erase(canonicalPath);
+    throw;
+  }
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  modules[canonicalPath] = {result, true};
+
   return result;
 }
+
+std::string ff::resolveImport(const std::string& import, const std::vector<std::string>& paths) {
+  std::string key = import;
+  for (auto& folder : paths) {
+    key += '\n' + folder;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto itr = g_resolvedImports.find(key);
+    if (itr != g_resolvedImports.end()) {
+      return itr->second;
+    }
+  }
+
+  std::string result = path::getImportFileFromPath(import, paths);
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_resolvedImports[key] = result;
+  return result;
+}
+
+static void prefetchImports(const std::shared_ptr<Registry>& registry, const std::string& filename, ff::ast::Node* tree) {
+  if (std::stoul(ff::config::get("import_threads")) == 0) {
+    return;
+  }
+
+  std::vector<std::string> imports;
+  collectImports(tree, imports);
+  if (imports.empty()) {
+    return;
+  }
+
+  auto importPaths = ff::Compiler::getImportPaths(filename);
+  for (auto& import : imports) {
+    std::string fullPath = ff::config::format(ff::resolveImport(import, importPaths));
+    if (!isNativeModule(fullPath)) {
+      prefetchModule(registry, fullPath);
+    }
+  }
+}
+
+void ff::prefetchImports(const std::string& filename, ast::Node* tree) {
+  ::prefetchImports(g_registry.registry, filename, tree);
+}
+
+bool ff::takePrefetchedModule(const std::string& filename, std::string& src, ast::Node*& tree) {
+  std::string canonicalPath = path::getCanonicalPath(filename);
+  auto& prefetched = g_registry.registry->prefetched;
+  std::shared_future<ParsedModule> future;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto itr = prefetched.find(canonicalPath);
+    if (itr == prefetched.end()) {
+      return false;
+    }
+    future = itr->second;
+    prefetched.erase(itr);
+  }
+
+  const ParsedModule& result = future.get();
+  src = result.src;
+  tree = result.tree;
+  return true;
+}
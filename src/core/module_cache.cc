@@ -0,0 +1,300 @@
+#include <ff/module_cache.h>
+#include <ff/compiler/compiler.h>
+#include <ff/utils/mapped_file.h>
+#include <ff/utils/path.h>
+#include <ff/config.h>
+#include <ff/errors.h>
+#include <ff/log.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static constexpr uint8_t kMagic[4] = {'F', 'F', 'M', '\0'};
+static constexpr uint64_t kCacheVersion = 1; // Must be bumped on any change to the key layout
+
+namespace {
+
+struct FileStamp {
+  std::string path;
+  uint64_t mtime = 0;
+  uint64_t size = 0;
+
+  bool operator==(const FileStamp& rhs) const {
+    return path == rhs.path && mtime == rhs.mtime && size == rhs.size;
+  }
+};
+
+struct Key {
+  FileStamp source;
+  uint64_t hash = 0;
+  std::string context;
+  std::vector<FileStamp> imports;
+};
+
+class KeyWriter {
+ private:
+  std::vector<uint8_t> m_data;
+
+ public:
+  std::vector<uint8_t>& data() {
+    return m_data;
+  }
+
+  void u64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      m_data.push_back((value >> (i * 8)) & 0xff);
+    }
+  }
+
+  void string(const std::string& value) {
+    u64(value.size());
+    m_data.insert(m_data.end(), value.begin(), value.end());
+  }
+
+  void stamp(const FileStamp& stamp) {
+    string(stamp.path);
+    u64(stamp.mtime);
+    u64(stamp.size);
+  }
+};
+
+/* Every read returns false once data runs out, so truncated entries are treated as misses */
+class KeyReader {
+ private:
+  const uint8_t* m_data;
+  size_t m_size;
+  size_t m_position = 0;
+
+ public:
+  KeyReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+  size_t position() const {
+    return m_position;
+  }
+
+  bool bytes(void* out, size_t size) {
+    if (size > m_size - m_position) {
+      return false;
+    }
+    memcpy(out, m_data + m_position, size);
+    m_position += size;
+    return true;
+  }
+
+  bool u64(uint64_t& value) {
+    uint8_t data[8];
+    if (!bytes(data, sizeof(data))) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; i++) {
+      value |= (uint64_t)data[i] << (i * 8);
+    }
+    return true;
+  }
+
+  bool string(std::string& value) {
+    uint64_t size;
+    if (!u64(size) || size > m_size - m_position) {
+      return false;
+    }
+    value.assign((const char*)m_data + m_position, size);
+    m_position += size;
+    return true;
+  }
+
+  bool stamp(FileStamp& stamp) {
+    return string(stamp.path) && u64(stamp.mtime) && u64(stamp.size);
+  }
+};
+
+} /* namespace */
+
+static uint64_t hashContent(const std::string& data) {
+  uint64_t hash = 0xcbf29ce484222325; // FNV-1a
+  for (char c : data) {
+    hash = (hash ^ (uint8_t)c) * 0x100000001b3;
+  }
+  return hash;
+}
+
+static bool stampFile(const std::string& filename, FileStamp& stamp) {
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0) {
+    return false;
+  }
+  stamp.path = filename;
+#ifdef __APPLE__
+  stamp.mtime = (uint64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+  stamp.mtime = (uint64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+  stamp.size = info.st_size;
+  return true;
+}
+
+/* Everything besides the file itself that decides which files its imports resolve to (see Compiler::import) */
+static std::string getContext() {
+  const char* envImportPath = std::getenv(FF_IMPORT_PATH_ENV_VAR);
+  return ff::path::getcwd() + "\n" + (envImportPath ? envImportPath : "") + "\n" + ff::config::get("import_path");
+}
+
+static std::string getEntryPath(const std::string& fullPath) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.ffm", (unsigned long long)hashContent(fullPath));
+  return ff::path::concat(ff::config::format(ff::config::get("cache_dir")), name);
+}
+
+static bool readKey(KeyReader& reader, Key& key) {
+  uint8_t magic[sizeof(kMagic)];
+  uint64_t version, count;
+  if (!reader.bytes(magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0
+      || !reader.u64(version) || version != kCacheVersion
+      || !reader.stamp(key.source) || !reader.u64(key.hash) || !reader.string(key.context)
+      || !reader.u64(count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    FileStamp stamp;
+    if (!reader.stamp(stamp)) {
+      return false;
+    }
+    key.imports.push_back(stamp);
+  }
+  return true;
+}
+
+static void writeEntry(const std::string& entryPath, const Key& key, const uint8_t* image, size_t size) {
+  KeyWriter writer;
+  writer.data().insert(writer.data().end(), kMagic, kMagic + sizeof(kMagic));
+  writer.u64(kCacheVersion);
+  writer.stamp(key.source);
+  writer.u64(key.hash);
+  writer.string(key.context);
+  writer.u64(key.imports.size());
+  for (auto& import : key.imports) {
+    writer.stamp(import);
+  }
+
+  // Entry is replaced with rename, so code still executing from a mapping of the old entry isn't affected
+  // Temporary file is unique per thread, isolates may store the same module at the same time
+  std::string tempPath = entryPath + "." + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+  std::ofstream file(tempPath, std::ios::binary);
+  bool written = file
+    && file.write((const char*)writer.data().data(), writer.data().size())
+    && file.write((const char*)image, size);
+  file.close();
+  if (!written || file.fail() || rename(tempPath.c_str(), entryPath.c_str()) != 0) {
+    unlink(tempPath.c_str());
+  }
+}
+
+bool ff::cache::isEnabled() {
+  return !config::getOr("cache_dir", "").empty() && config::get("debug") == "0";
+}
+
+/* Maps entry of fullPath and checks its key, source is set to the current stamp of the file */
+static bool findEntry(const std::string& fullPath, ff::Ref<ff::MappedFile>& image, Key& key, size_t& keySize, FileStamp& source) {
+  image = ff::MappedFile::open(getEntryPath(fullPath));
+  if (!image.get()) {
+    return false;
+  }
+
+  KeyReader reader(image->data(), image->size());
+  if (!readKey(reader, key) || key.source.path != fullPath || !stampFile(fullPath, source) || key.context != getContext()) {
+    return false;
+  }
+  keySize = reader.position();
+
+  for (auto& import : key.imports) {
+    FileStamp current;
+    if (!stampFile(import.path, current) || !(current == import)) {
+      return false;
+    }
+  }
+
+  if (source == key.source) {
+    return true;
+  }
+
+  // File was touched, entry is still valid if content is the same
+  if (source.size != key.source.size) {
+    return false;
+  }
+  std::ifstream sourceFile(fullPath, std::ios::binary);
+  std::string src((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+  return sourceFile && hashContent(src) == key.hash;
+}
+
+bool ff::cache::isValid(const std::string& filename) {
+  Ref<MappedFile> image;
+  Key key;
+  size_t keySize;
+  FileStamp source;
+  return findEntry(path::getFullPath(filename), image, key, keySize, source);
+}
+
+bool ff::cache::load(const std::string& filename, bytecode::ModuleImage& module) {
+  std::string fullPath = path::getFullPath(filename);
+
+  Ref<MappedFile> image;
+  Key key;
+  size_t keySize;
+  FileStamp source;
+  if (!findEntry(fullPath, image, key, keySize, source)) {
+    return false;
+  }
+
+  const uint8_t* data = image->data() + keySize;
+  size_t size = image->size() - keySize;
+  try {
+    module = bytecode::deserializeModule(filename, data, size, image);
+  } catch (CompileError& e) {
+    return false;
+  }
+
+  if (!(source == key.source)) {
+    key.source = source;
+    writeEntry(getEntryPath(fullPath), key, data, size);
+  }
+
+  return true;
+}
+
+void ff::cache::store(const std::string& filename, const std::string& src, const bytecode::ModuleImage& module) {
+  std::vector<uint8_t> image;
+  try {
+    image = bytecode::serializeModule(module);
+  } catch (CompileError& e) {
+    if (config::get("verbose") != "0") {
+      warning("Module '%s' can't be cached: %s", filename.c_str(), e.what());
+    }
+    return;
+  }
+
+  Key key;
+  std::string fullPath = path::getFullPath(filename);
+  if (!stampFile(fullPath, key.source) || key.source.size != src.size()) {
+    return; // Changed since it was read
+  }
+  key.hash = hashContent(src);
+  key.context = getContext();
+
+  for (auto& import : module.code->getModulePaths()) {
+    FileStamp stamp;
+    if (!stampFile(path::getFullPath(import.second), stamp)) {
+      return;
+    }
+    key.imports.push_back(stamp);
+  }
+
+  if (!path::createDirectories(config::format(config::get("cache_dir")))) {
+    return;
+  }
+
+  writeEntry(getEntryPath(fullPath), key, image.data(), image.size());
+}
@@ -3,7 +3,25 @@
 #include <ff/errors.h>
 #include <ff/memory.h>
 #include <ff/runtime.h>
+#include <algorithm>
 #include <cstdio>
+#include <atomic>
+
+static std::atomic<uint64_t> g_nextFieldsVersion {1};
+
+static inline uint64_t nextFieldsVersion() {
+  return g_nextFieldsVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
+ff::Object::FieldTable::FieldTable() : version(nextFieldsVersion()) {
+  fields.reserve(1); // Most objects have a few fields, first insert would otherwise allocate a dozen buckets
+}
+
+ff::Object::FieldTable::FieldTable(const FieldTable& other) : fields(other.fields), version(nextFieldsVersion()) {}
+
+bool ff::Object::FieldTable::empty() const {
+  return fields.empty();
+}
 
 ff::Object::Object(ObjectType type) : m_type(type) {}
 
@@ -27,61 +45,113 @@ bool ff::Object::equals(Ref<Object> other) const {
   return this == other.get();
 }
 
-bool ff::Object::hasField(const std::string& key) const {
-  return m_fields.find(key) != m_fields.end();
+bool ff::Object::hasField(const Symbol& key) const {
+  auto& fields = m_fields.get().fields;
+  return fields.find(key) != fields.end();
 }
 
-ff::Ref<ff::Object> ff::Object::getField(const std::string& key) {
-  if (m_fields.find(key) == m_fields.end()) {
+ff::Ref<ff::Object> ff::Object::getField(const Symbol& key) {
+  auto& fields = m_fields.get().fields;
+  auto itr = fields.find(key);
+  if (itr == fields.end()) {
     throw RuntimeError::createf("No such field: '%s'", key.c_str());
   }
-  return m_fields[key];
+  return itr->second;
+}
+
+void ff::Object::setField(const Symbol& key, Ref<Object> value) {
+  if (isImmortal()) {
+    throw RuntimeError::createf("Can't set field '%s' of a shared object", key.c_str());
+  }
+  auto& table = m_fields.getMutable();
+  table.version = nextFieldsVersion();
+  table.fields[key] = value;
+}
+
+ff::Object::FieldsType& ff::Object::getFields() {
+  // Immortal objects are shared by isolates and never modified, so their storage is never duplicated
+  if (isImmortal()) {
+    return const_cast<FieldsType&>(m_fields.get().fields);
+  }
+  // Caller can modify fields through the reference
+  auto& table = m_fields.getMutable();
+  table.version = nextFieldsVersion();
+  return table.fields;
+}
+
+const ff::Object::FieldsType& ff::Object::getFields() const {
+  return m_fields.get().fields;
 }
 
-void ff::Object::setField(const std::string& key, Ref<Object> value) {
-  m_fields[key] = value;
+std::vector<std::pair<ff::Symbol, ff::Ref<ff::Object>>> ff::Object::getSortedFields() const {
+  auto& fields = m_fields.get().fields;
+  std::vector<std::pair<Symbol, Ref<Object>>> result(fields.begin(), fields.end());
+  std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first < rhs.first;
+  });
+  return result;
 }
 
-std::map<std::string, ff::Ref<ff::Object>>& ff::Object::getFields() {
-  return m_fields;
+void ff::Object::shareFields(const Object& other) {
+  if (isImmortal()) {
+    throw RuntimeError::createf("Can't set fields of a shared object");
+  }
+  m_fields = other.m_fields;
 }
 
-const std::map<std::string, ff::Ref<ff::Object>>& ff::Object::getFields() const {
-  return m_fields;
+void ff::Object::makeFieldsImmortal() const {
+  m_fields.makeImmortal();
+}
+
+uint64_t ff::Object::getFieldsVersion() const {
+  return m_fields.get().version;
 }
 
 ff::Ref<ff::Object> ff::Object::cast(VM* context, Ref<Object> object, const std::string& typeName) {
   const std::string castFunctionName = "__as_" + typeName + "__";
   context->callMember(object, castFunctionName);
-  return context->pop();
+  return context->pop().box();
 }
 
 bool ff::Object::toBool(VM* context, Ref<Object> object) {
   if (object.get()) {
-    if (object->isType() && object.as<Type>()->getTypeName() != "null") {
+    if (object->isType()) {
       return true;
     } else if (isOfType(object, BoolType::getInstance())) {
       return types::boolval(object);
     } else {
-      context->callMember(object, "__bool__", 0);
+      static const Symbol kBoolMethod("__bool__");
+      context->callMember(object, kBoolMethod, 0);
       return types::boolval(context->popCheckType(BoolType::getInstance()));
     }
   }
   return false;
 }
 
-ff::Type::Type(const std::string& typeName) : Object(OTYPE_TYPE), m_typeName(typeName) {}
+static std::atomic<ff::TypeId> g_nextTypeId {ff::TYPEID_BUILTIN_COUNT};
+
+ff::Type::Type(const std::string& typeName) : Type(typeName, g_nextTypeId++) {}
 
-std::string ff::Type::getTypeName() const {
+ff::Type::Type(const std::string& typeName, TypeId typeId) : Object(OTYPE_TYPE), m_typeName(typeName), m_typeId(typeId) {}
+
+const std::string& ff::Type::getTypeName() const {
   return m_typeName;
 }
 
+ff::TypeId ff::Type::getTypeId() const {
+  return m_typeId;
+}
+
 bool ff::Type::equals(Ref<Object> other) const {
-  return other->getObjectType() == OTYPE_TYPE && other.as<Type>()->getTypeName() == getTypeName();
+  return other->getObjectType() == OTYPE_TYPE && other.as<Type>()->getTypeId() == getTypeId();
 }
 
-ff::Instance::Instance(Ref<Type> type) : Object(OTYPE_INSTANCE), m_type(type) {}
+ff::Instance::Instance(Ref<Type> type) : Object(OTYPE_INSTANCE), m_type(type.get()) {}
 
 ff::Ref<ff::Type> ff::Instance::getType() const {
-  return m_type;
+  return Ref<Type>(m_type);
+}
+
+ff::TypeId ff::Instance::getTypeId() const {
+  return m_type->getTypeId();
 }
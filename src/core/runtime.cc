@@ -3,9 +3,60 @@
 #include <ff/types.h>
 #include <ff/builtins.h>
 #include <mrt/console/colors.h>
+#include <cstring>
 
 using namespace ff::types;
 
+namespace {
+
+/* Operand of a built-in type, taken either from an inline value or from a boxed int/float/bool/string */
+struct Operand {
+  enum Kind { NONE, NUL, INT, FLOAT, BOOL, STRING } kind = NONE;
+  union {
+    int64_t i;
+    double f;
+    bool b;
+    const std::string* s;
+  };
+};
+
+} /* namespace */
+
+static thread_local size_t g_copyCount = 0;
+
+// Methods called by the VM itself
+static const ff::Symbol kCopyMethod("__copy__");
+static const ff::Symbol kAssignMethod("__assign__");
+static const ff::Symbol kBoolMethod("__bool__");
+static const ff::Symbol kNotMethod("__not__");
+static const ff::Symbol kNegMethod("__neg__");
+static const ff::Symbol kIncMethod("__inc__");
+static const ff::Symbol kDecMethod("__dec__");
+
+static inline Operand toOperand(const ff::Value& value) {
+  Operand operand;
+  switch (value.getTag()) {
+    case ff::Value::VTAG_NULL:  operand.kind = Operand::NUL; break;
+    case ff::Value::VTAG_INT:   operand.kind = Operand::INT;   operand.i = value.asInt(); break;
+    case ff::Value::VTAG_FLOAT: operand.kind = Operand::FLOAT; operand.f = value.asFloat(); break;
+    case ff::Value::VTAG_BOOL:  operand.kind = Operand::BOOL;  operand.b = value.asBool(); break;
+    default: {
+      ff::Object* object = value.asObject().get();
+      if (!object->isInstance()) {
+        break;
+      }
+      switch (((ff::Instance*)object)->getTypeId()) {
+        case ff::TYPEID_INT:    operand.kind = Operand::INT;    operand.i = ((ff::Int*)object)->value; break;
+        case ff::TYPEID_FLOAT:  operand.kind = Operand::FLOAT;  operand.f = ((ff::Float*)object)->value; break;
+        case ff::TYPEID_BOOL:   operand.kind = Operand::BOOL;   operand.b = ((ff::Bool*)object)->value; break;
+        case ff::TYPEID_STRING: operand.kind = Operand::STRING; operand.s = &((ff::String*)object)->value; break;
+        default: break;
+      }
+    }
+  }
+  return operand;
+}
+
 ff::RuntimeError::RuntimeError(const std::string& filename, int line, const std::string& msg) : m_filename(filename), m_line(line), m_message(msg) {}
 
 ff::RuntimeError ff::RuntimeError::flcreate(const std::string& filename, int line, const std::string& msg) {
@@ -60,18 +111,18 @@ void ff::RuntimeError::print() const {
     m_message.c_str());
 }
 
-ff::VM::VM() {
-  m_globals["int"]     = IntType::getInstance().asRefTo<Object>();
-  m_globals["bool"]    = BoolType::getInstance().asRefTo<Object>();
-  m_globals["float"]   = FloatType::getInstance().asRefTo<Object>();
-  m_globals["string"]  = StringType::getInstance().asRefTo<Object>();
-  m_globals["dict"]    = DictType::getInstance().asRefTo<Object>();
-  m_globals["vector"]  = VectorType::getInstance().asRefTo<Object>();
-  m_globals["exit"]    = obj(fn_exit);
-  m_globals["assert"]  = obj(fn_assert);
-  m_globals["type"]    = obj(fn_type);
-  m_globals["inspect"] = obj(fn_inspect);
-  m_globals["memaddr"] = obj(fn_memaddr);
+ff::VM::VM() : m_stack(std::stoul(config::get("stack_size"))), m_callStack(std::stoul(config::get("call_depth"))) {
+  setGlobal("int",     IntType::getInstance().asRefTo<Object>());
+  setGlobal("bool",    BoolType::getInstance().asRefTo<Object>());
+  setGlobal("float",   FloatType::getInstance().asRefTo<Object>());
+  setGlobal("string",  StringType::getInstance().asRefTo<Object>());
+  setGlobal("dict",    DictType::getInstance().asRefTo<Object>());
+  setGlobal("vector",  VectorType::getInstance().asRefTo<Object>());
+  setGlobal("exit",    obj(fn_exit));
+  setGlobal("assert",  obj(fn_assert));
+  setGlobal("type",    obj(fn_type));
+  setGlobal("inspect", obj(fn_inspect));
+  setGlobal("memaddr", obj(fn_memaddr));
 }
 
 ff::VM::~VM() {}
@@ -82,20 +133,12 @@ void ff::VM::run(Ref<Code> code) {
 
 void ff::VM::runMain(Ref<Code> code) {
   runCode(code);
-  if (m_globals.find(config::get("entry")) == m_globals.end()) {
+  if (!hasGlobal(config::get("entry"))) {
     throw createError("Cannot find entry function ('%s')", config::get("entry").c_str());
   }
   call(config::get("entry"));
 }
 
-void ff::VM::run() {
-  m_running = true;
-  getCode()->resetRead();
-  while (m_running && !m_requestStop && getCode()->canRead()) {
-    m_running = executeInstruction((Opcode)getCode()->read<uint8_t>());
-  }
-}
-
 void ff::VM::stop() {
   m_requestStop = true;
 }
@@ -104,6 +147,10 @@ ff::VM::CallFrame& ff::VM::currentFrame() {
   return m_callStack.peek();
 }
 
+size_t ff::VM::getCopyCount() {
+  return g_copyCount;
+}
+
 int ff::VM::getReturnCode() {
   return m_returnCode;
 }
@@ -113,41 +160,64 @@ void ff::VM::setReturnCode(int returnCode) {
 }
 
 ff::Stack<ff::VM::StackType>& ff::VM::getStack() {
-  return currentFrame().context.stack;
+  return m_stack;
 }
 
-std::map<std::string, ff::Ref<ff::Object>>& ff::VM::getGlobals() {
-  return m_globals;
+std::map<std::string, ff::Ref<ff::Object>> ff::VM::getGlobals() {
+  std::map<std::string, Ref<Object>> result;
+  for (uint32_t slot = 0; slot < m_globals.size(); slot++) {
+    if (m_globals[slot].isDefined) {
+      result[globals::getName(slot)] = m_globals[slot].value;
+    }
+  }
+  return result;
 }
 
-ff::Ref<ff::Code>& ff::VM::getCode() {
-  return currentFrame().context.code;
+bool ff::VM::hasGlobal(const std::string& name) {
+  uint32_t slot = 0;
+  return globals::findSlot(name, slot) && slot < m_globals.size() && m_globals[slot].isDefined;
 }
 
-void ff::VM::push(Ref<Object> obj) {
-  getStack().push(obj);
+ff::Ref<ff::Object> ff::VM::getGlobal(const std::string& name) {
+  uint32_t slot = 0;
+  if (globals::findSlot(name, slot) && slot < m_globals.size()) {
+    return m_globals[slot].value;
+  }
+  return Ref<Object>();
 }
 
-ff::Ref<ff::Object> ff::VM::pop() {
-  return getStack().pop();
+void ff::VM::setGlobal(const std::string& name, Ref<Object> value) {
+  Global& global = getGlobalSlot(globals::getSlot(name));
+  global.value = value;
+  global.isDefined = true;
 }
 
-std::vector<ff::Ref<ff::Object>> ff::VM::pop(int count, bool reverse) {
-  std::vector<Ref<Object>> result;
-  for (int i = 0; i < count; i++) {
-    if (reverse) {
-      result.insert(result.begin(), getStack().pop());
-    } else {
-      result.push_back(getStack().pop());
-    }
+ff::VM::Global& ff::VM::getGlobalSlot(uint32_t slot) {
+  if (slot >= m_globals.size()) {
+    m_globals.resize(globals::count() > slot ? globals::count() : slot + 1);
   }
-  return result;
+  return m_globals[slot];
+}
+
+ff::Ref<ff::Code>& ff::VM::getCode() {
+  return currentFrame().code;
+}
+
+void ff::VM::push(Value value) {
+  m_stack.push(std::move(value));
 }
 
-std::vector<ff::Ref<ff::Object>> ff::VM::popFrom(int frameOffset, int count) {
-  std::vector<Ref<Object>> result;
+ff::Value ff::VM::pop() {
+  return m_stack.pop();
+}
+
+std::vector<ff::Value> ff::VM::pop(int count, bool reverse) {
+  if (count > m_stack.size()) {
+    throw StackUnderflowException();
+  }
+  std::vector<Value> result(count);
   for (int i = 0; i < count; i++) {
-    result.insert(result.begin(), m_callStack.peek(frameOffset).context.stack.pop());
+    result[reverse ? count - 1 - i : i] = m_stack.pop();
   }
   return result;
 }
@@ -169,18 +239,22 @@ uint8_t ff::VM::peek(int i) {
 }
 
 ff::RuntimeError ff::VM::createError(const std::string& msg) {
-  return RuntimeError::flcreate(getCode()->getFilename(), getCode()->getLine(getCode()->getReadIndex()), msg);
+  return RuntimeError::flcreate(getCode()->getFilename(), getCode()->getLine(getCode()->getReadIndex() - 1), msg);
 }
 
 ff::RuntimeError ff::VM::createError(const char* fmt, ...) {
   va_list args;
   va_start(args, fmt);
-  auto err = RuntimeError::flvcreatef(getCode()->getFilename(), getCode()->getLine(getCode()->getReadIndex()), fmt, args);
+  auto err = RuntimeError::flvcreatef(getCode()->getFilename(), getCode()->getLine(getCode()->getReadIndex() - 1), fmt, args);
   va_end(args);
   return err;
 }
 
 void ff::VM::call(Ref<Object> object, int argc) {
+  callObject(object, argc, true);
+}
+
+void ff::VM::callObject(const Ref<Object>& object, int argc, bool nested) {
   if (!object.get()) {
     throw createError("cannot call null");
   }
@@ -189,13 +263,13 @@ void ff::VM::call(Ref<Object> object, int argc) {
     if (fn->args.size() != argc) {
       throw createError("Expected %d arguments, but got %d", fn->args.size(), argc);
     }
-    callFunction(fn, pop(fn->args.size(), true));
+    invokeFunction(fn, argc, nested);
   } else if (isOfType(object, NativeFunctionType::getInstance())) {
     Ref<NativeFunction> fn = object.asRefTo<NativeFunction>();
     if (fn->args.size() != argc) {
       throw createError("Expected %d arguments, but got %d", fn->args.size(), argc);
     }
-    callNativeFunction(fn, pop(fn->args.size()));
+    callNative(fn, argc);
   } else {
     throw createError("Attempt to call an object of type '%s'", object.as<Instance>()->getType()->getTypeName().c_str());
   }
@@ -203,7 +277,10 @@ void ff::VM::call(Ref<Object> object, int argc) {
 
 void ff::VM::call(Ref<Object> object, const std::vector<Ref<Object>>& args) {
   if (isOfType(object, FunctionType::getInstance())) {
-    callFunction(object.asRefTo<Function>(), args);
+    for (auto itr = args.rbegin(); itr != args.rend(); itr++) {
+      push(*itr);
+    }
+    callFunction(object.asRefTo<Function>(), args.size());
   } else if (isOfType(object, NativeFunctionType::getInstance())) {
     callNativeFunction(object.asRefTo<NativeFunction>(), args);
   } else {
@@ -211,37 +288,110 @@ void ff::VM::call(Ref<Object> object, const std::vector<Ref<Object>>& args) {
   }
 }
 
-void ff::VM::callMember(Ref<Object> self, const std::string& memberName, int argc) {
+void ff::VM::callMember(Ref<Object> self, const Symbol& memberName, int argc) {
+  bool implicitSelf = true;
+  Ref<Object> fnObject = findMember(self, memberName, implicitSelf);
+  callFoundMember(self, memberName, fnObject, implicitSelf, argc, true);
+}
+
+/* Object whose fields are searched first when looking up a member of object
+ * Instances without own fields are represented by their type, so they share inline cache entries
+ */
+static inline const ff::Object* getMemberReceiver(const ff::Object* object) {
+  if (!object->isInstance()) {
+    return object;
+  }
+  if (((const ff::Instance*)object)->getTypeId() == ff::TYPEID_CLASS_INSTANCE) {
+    return ((const ff::ClassInstance*)object)->getClass().get();
+  }
+  if (object->getFields().empty()) {
+    return ((const ff::Instance*)object)->getType().get();
+  }
+  return object;
+}
+
+static inline ff::ClassInstance* asClassInstance(const ff::Ref<ff::Object>& object) {
+  if (object.get() && object->isInstance() && object.as<ff::Instance>()->getTypeId() == ff::TYPEID_CLASS_INSTANCE) {
+    return object.as<ff::ClassInstance>();
+  }
+  return nullptr;
+}
+
+static inline void cacheSlot(ff::InlineCache& cache, const ff::Class* classObject, uint32_t slot) {
+  ff::InlineCache::Entry& entry = cache.replace();
+  entry.receiver = classObject;
+  entry.receiverVersion = classObject->getFieldsVersion();
+  entry.owner = nullptr;
+  entry.member.reset();
+  entry.slot = slot;
+}
+
+ff::Ref<ff::Object> ff::VM::getField(const Ref<Object>& object, const Symbol& name, InlineCache& cache, uint32_t expectedSlot) {
+  if (!object.get()) {
+    throw createError("Cannot get field of null");
+  }
+  if (ClassInstance* instance = asClassInstance(object)) {
+    int slot = instance->getClass()->findSlot(name);
+    if (slot >= 0 && slot < instance->getSlotCount()) {
+      if (expectedSlot == InlineCache::kNoSlot || expectedSlot == slot) {
+        cacheSlot(cache, instance->getClass().get(), slot);
+      }
+      return instance->getSlot(slot);
+    }
+  }
+  Ref<Object> value = object->getField(name);
+  InlineCache::Entry& entry = cache.replace();
+  entry.receiver = object.get();
+  entry.receiverVersion = object->getFieldsVersion();
+  entry.owner = nullptr;
+  entry.member = value;
+  entry.slot = InlineCache::kNoSlot;
+  return value;
+}
+
+void ff::VM::setField(const Ref<Object>& object, const Symbol& name, Ref<Object> value, InlineCache& cache, uint32_t expectedSlot) {
+  if (!object.get()) {
+    throw createError("Cannot set field of null");
+  }
+  if (ClassInstance* instance = asClassInstance(object)) {
+    int slot = instance->getClass()->findSlot(name);
+    if (slot >= 0 && slot < instance->getSlotCount() && !instance->isImmortal()) {
+      if (expectedSlot == InlineCache::kNoSlot || expectedSlot == slot) {
+        cacheSlot(cache, instance->getClass().get(), slot);
+      }
+      instance->setSlot(slot, value);
+      return;
+    }
+  }
+  object->setField(name, value);
+}
+
+ff::Ref<ff::Object> ff::VM::findMember(const Ref<Object>& self, const Symbol& memberName, bool& implicitSelf, InlineCache::Entry* entry) {
   if (!self.get()) {
     throw createError("Cannot call member of null");
   }
-  bool implicitSelf = true;
+  const Object* owner = nullptr;
   Ref<Object> fnObject;
+  implicitSelf = true;
   if (self->isInstance()) {
-    if (isOfType(self, ModuleType::getInstance())) {
+    TypeId typeId = self.as<Instance>()->getTypeId();
+    if (typeId == TYPEID_MODULE) {
       implicitSelf = false;
     }
-    if (isOfType(self, ClassType::getInstance())) {
-      Ref<Class> classObject = self.asRefTo<Class>();
+    if (typeId == TYPEID_CLASS_INSTANCE) {
+      const Ref<Class>& classObject = self.as<ClassInstance>()->getClass();
       if (classObject->hasField(memberName)) {
-        implicitSelf = false;
         fnObject = classObject->getField(memberName);
-      } else if (classObject->getType()->hasField(memberName)) {
-        fnObject = classObject->getType()->getField(memberName);
-      } else {
-        throw createError("Member '%s' cannot be found", memberName.c_str());
-      }
-    }
-    if (isOfType(self.asRefTo<Instance>(), ClassInstanceType::getInstance())) {
-      Ref<ClassInstance> classInstance = self.asRefTo<ClassInstance>();
-      if (classInstance->getClass()->hasField(memberName)) {
-        fnObject = classInstance->getClass()->getField(memberName);
       } else {
         throw createError("Member '%s' cannot be found", memberName.c_str());
       }
     } else if (self->hasField(memberName)) {
+      if (typeId == TYPEID_CLASS) {
+        implicitSelf = false;
+      }
       fnObject = self->getField(memberName);
     } else if (self.as<Instance>()->getType()->hasField(memberName)) {
+      owner = self.as<Instance>()->getType().get();
       fnObject = self.as<Instance>()->getType()->getField(memberName);
     } else {
       throw createError("Member '%s' cannot be found", memberName.c_str());
@@ -254,29 +404,51 @@ void ff::VM::callMember(Ref<Object> self, const std::string& memberName, int arg
       throw createError("Member '%s' cannot be found", memberName.c_str());
     }
   }
-  std::vector<Ref<Object>> args = pop(argc);
-  if (implicitSelf) {
-    args.insert(args.begin(), self);
+
+  if (entry) {
+    const Object* receiver = getMemberReceiver(self.get());
+    entry->receiver = receiver;
+    entry->receiverVersion = receiver->getFieldsVersion();
+    entry->owner = owner != receiver ? owner : nullptr;
+    entry->ownerVersion = entry->owner ? owner->getFieldsVersion() : 0;
+    entry->member = fnObject;
+    entry->implicitSelf = implicitSelf;
+    entry->slot = InlineCache::kNoSlot;
   }
+
+  return fnObject;
+}
+
+void ff::VM::callFoundMember(const Ref<Object>& self, const Symbol& memberName, const Ref<Object>& fnObject, bool implicitSelf, int argc, bool nested) {
   if (isOfType(fnObject, FunctionType::getInstance())) {
     Ref<Function> fn = fnObject.asRefTo<Function>();
     if (fn->args.size() - (implicitSelf ? 1 : 0) != argc) {
       throw createError("%s:Expected %d arguments, but got %d", memberName.c_str(), fn->args.size()-1, argc);
     }
-    std::reverse(args.begin(), args.end());
-    callFunction(fn, args);
+    // Arguments are already on the stack, self goes on top of them as the first argument
+    if (implicitSelf) {
+      push(self);
+    }
+    invokeFunction(fn, argc + (implicitSelf ? 1 : 0), nested);
   } else if (isOfType(fnObject, NativeFunctionType::getInstance())) {
     Ref<NativeFunction> fn = fnObject.asRefTo<NativeFunction>();
     if (fn->args.size() - (implicitSelf ? 1 : 0) != argc) {
       throw createError("%s:Expected %d arguments, but got %d", memberName.c_str(), fn->args.size()-1, argc);
     }
-    callNativeFunction(fn, args);
+    if (implicitSelf) {
+      push(self);
+    }
+    callNative(fn, argc + (implicitSelf ? 1 : 0));
   } else {
     throw createError("%s:Attempt to call an object of type '%s'", memberName.c_str(), fnObject.as<Instance>()->getType()->getTypeName().c_str());
   }
 }
 
-void ff::VM::callMember(Ref<Object> self, const std::string& memberName, std::vector<Ref<Object>> args) {
+void ff::VM::callMember(Ref<Object> self, const Symbol& memberName, std::vector<Ref<Object>> args) {
+  callMemberArgs(self, memberName, args, true);
+}
+
+void ff::VM::callMemberArgs(const Ref<Object>& self, const Symbol& memberName, const std::vector<Ref<Object>>& args, bool nested) {
   if (!self.get()) {
     throw createError("cannot call member of null");
   }
@@ -308,8 +480,10 @@ void ff::VM::callMember(Ref<Object> self, const std::string& memberName, std::ve
     if (fn->args.size() != args.size()) {
       throw createError("%s: Expected %d arguments, but got %d", memberName.c_str(), fn->args.size()-1, args.size());
     }
-    std::reverse(args.begin(), args.end());
-    callFunction(fn, args);
+    for (auto itr = args.rbegin(); itr != args.rend(); itr++) {
+      push(*itr);
+    }
+    invokeFunction(fn, args.size(), nested);
   } else if (isOfType(fnObject, NativeFunctionType::getInstance())) {
     Ref<NativeFunction> fn = fnObject.asRefTo<NativeFunction>();
     if (fn->args.size() != args.size()) {
@@ -321,422 +495,817 @@ void ff::VM::callMember(Ref<Object> self, const std::string& memberName, std::ve
   }
 }
 
-void ff::VM::callFunction(Ref<Function> fn, const std::vector<Ref<Object>>& args) {
+void ff::VM::callFunction(Ref<Function> fn, int argc) {
+  invokeFunction(fn, argc, true);
+}
+
+void ff::VM::invokeFunction(const Ref<Function>& fn, int argc, bool nested) {
 #ifdef _FF_DEBUG_TRACE
   if (config::get("debug") != "0") {
     printf("     | CALL %p\n", fn.get());
   }
 #endif
-  runCode(fn->code, args);
+  if (nested) {
+    runCode(fn->code, argc);
+  } else {
+    enterCode(fn->code, argc);
+  }
 }
 
 void ff::VM::callNativeFunction(Ref<NativeFunction> fn, const std::vector<Ref<Object>>& args) {
+  for (auto itr = args.rbegin(); itr != args.rend(); itr++) {
+    push(*itr);
+  }
+  callNative(fn, args.size());
+}
+
+/* Arguments are expected on top of the stack (first argument on top), they are boxed in place
+ * and passed to the native function without copying
+ */
+void ff::VM::callNative(const Ref<NativeFunction>& fn, int argc) {
 #ifdef _FF_DEBUG_TRACE
   if (config::get("debug") != "0") {
     printf("     | CALL_NATIVE %p\n", fn.get());
   }
 #endif
-  push(fn->func(this, args));
+  size_t args = m_stack.size() - argc;
+  for (size_t i = args; i < m_stack.size(); i++) {
+    m_stack[i].boxInPlace();
+  }
+  NativeArgs view(m_stack.data() + m_stack.size(), argc);
+  Ref<Object> result;
+  if (fn->fastFunc) {
+    result = fn->fastFunc(this, view);
+  } else {
+    std::vector<Ref<Object>> vector(argc);
+    for (int i = 0; i < argc; i++) {
+      vector[i] = view[i];
+    }
+    result = fn->func(this, std::move(vector));
+  }
+  m_stack.truncate(args);
+  push(std::move(result));
 }
 
-void ff::VM::runCode(Ref<Code> code, std::vector<Ref<Object>> args) {
+void ff::VM::runCode(Ref<Code> code, int argc) {
+  try {
+    enterCode(code, argc);
+    run();
+  } catch (const StackOverflowException&) {
+    throw createError("Stack overflow");
+  }
+}
+
+void ff::VM::enterCode(Ref<Code> code, int argc) {
   if (m_callStack.size() > 0) {
-    m_callStack.peek().context.codeOffset = getCode()->getReadIndex();
+    m_callStack.peek().codeOffset = getCode()->getReadIndex();
   }
-  m_callStack.push({Stack<Ref<Object>>(), 0, code});
+  m_callStack.push({code, 0, m_stack.size() - argc});
   for (auto& module : code->getModules()) {
-    m_globals[module.first] = module.second;
+    setGlobal(module.first, module.second);
   }
-  for (auto itr = args.rbegin(); itr != args.rend(); itr++) {
-    push(*itr);
+}
+
+/* Reuses current frame for a tail call, arguments on top of the stack are moved to the frame's base */
+void ff::VM::replaceFrame(Ref<Code> code, int argc) {
+  CallFrame& frame = currentFrame();
+  size_t args = m_stack.size() - argc;
+  for (int i = 0; i < argc; i++) {
+    m_stack[frame.base + i] = std::move(m_stack[args + i]);
+  }
+  m_stack.truncate(frame.base + argc);
+  frame.code = std::move(code);
+  frame.codeOffset = 0;
+  for (auto& module : frame.code->getModules()) {
+    setGlobal(module.first, module.second);
   }
-  run();
 }
 
 void ff::VM::call(const std::string& functionName) {
-  if (m_globals.find(functionName) != m_globals.end()) {
-    call(m_globals[functionName]);
+  if (hasGlobal(functionName)) {
+    call(getGlobal(functionName));
   } else {
     throw createError("Unknown variable");
   }
 }
 
-ff::Ref<ff::Object> ff::VM::returnCall() {
-  Ref<Object> result = getStack().canPop() ? pop() : Ref<Object>();
+ff::Value ff::VM::returnCall() {
+  size_t base = currentFrame().base;
+  Value result = m_stack.size() > base ? pop() : Value();
+  m_stack.truncate(base);
   m_callStack.pop();
   if (m_callStack.size() > 1) {
-    getCode()->setReadIndex(m_callStack.peek().context.codeOffset);
-    m_running = true;
+    getCode()->setReadIndex(m_callStack.peek().codeOffset);
   }
   return result;
 }
 
-bool ff::VM::executeInstruction(Opcode op) {
-#ifdef _FF_DEBUG_TRACE
-  if (config::get("debug") != "0") {
-    printf("%04zx | %s\n", getCode()->getReadIndex()-1, opcodeToString(op).c_str());
+void ff::VM::printStack() {
+  size_t base = m_callStack.canPop() ? currentFrame().base : 0;
+  printf("[");
+  for (size_t i = base; i < m_stack.size(); i++) {
+    printf("%s%s", (i == base ? "" : ", "), m_stack[i].toString().c_str());
   }
+  printf("]\n");
+}
+
+/* Dispatch
+ *
+ * run() executes the current frame until it returns (OP_RETURN) or until OP_HALT.
+ * Calls to ff functions made by instructions don't recurse: callee's frame is pushed and
+ * the loop switches to it (VM_LOAD_FRAME), OP_RETURN switches back to the caller.
+ * Only calls made from C++ (native functions, casts, truthiness checks) start a nested run().
+ * Instruction pointer is kept in a local and only written back to Code (VM_SYNC)
+ * before anything that can throw, call out, or inspect the read index.
+ * With GCC/Clang dispatch is direct-threaded (computed goto), otherwise
+ * (or with _FF_NO_THREADED_DISPATCH) falls back to a plain switch.
+ * Stop requests (exit()) are only checked on back-edges and after calls.
+ */
+
+#if defined(__GNUC__) && !defined(_FF_NO_THREADED_DISPATCH)
+#define _FF_THREADED_DISPATCH 1
 #endif
 
+#ifdef _FF_DEBUG_TRACE
+#define VM_TRACE_BEFORE() \
+  if (config::get("debug") != "0") printf("%04zx | %s\n", (size_t)(ip - base), opcodeToString((Opcode)*ip).c_str());
+#define VM_TRACE_AFTER() \
+  if (config::get("debug") != "0") { printf("     "); printStack(); }
+#else
+#define VM_TRACE_BEFORE()
+#define VM_TRACE_AFTER()
+#endif
+
+#ifdef _FF_THREADED_DISPATCH
+#define VM_CASE(op)   L_##op:
+#define VM_DISPATCH() do { VM_TRACE_BEFORE(); goto *dispatchTable[*ip++]; } while (0)
+#else
+#define VM_CASE(op)   case op:
+#define VM_DISPATCH() do { VM_TRACE_BEFORE(); goto dispatch; } while (0)
+#endif
+
+#define VM_NEXT()         do { VM_TRACE_AFTER(); VM_DISPATCH(); } while (0)
+#define VM_SYNC()         code->setReadIndex(ip - base)
+#define VM_CHECK_STOP()   if (m_requestStop) return
+#define VM_NEXT_CALL()    do { VM_CHECK_STOP(); if (m_callStack.size() != depth) VM_LOAD_FRAME(); VM_NEXT(); } while (0)
+#define VM_RETURN() \
+  do { \
+    push(returnCall()); \
+    if (m_callStack.size() < entryDepth) return; \
+    VM_LOAD_FRAME(); \
+    VM_NEXT_CALL(); \
+  } while (0)
+#define VM_LOAD_FRAME() \
+  do { \
+    CallFrame& frame = currentFrame(); \
+    code = frame.code.get(); \
+    base = code->data(); \
+    ip = base + frame.codeOffset; \
+    globalSlots = code->getGlobals().data(); \
+    locals = &m_stack[frame.base]; \
+    depth = m_callStack.size(); \
+  } while (0)
+#define VM_READ(type)     readOperand<type>(ip)
+#define VM_READ_GLOBAL()  globalSlots[VM_READ(uint32_t)]
+
+/* Inline int operands are computed in place, other built-in types go through binaryOp
+ * and only user types call the operator method
+ */
+#define VM_BINARY_OP_IF(opcode, method, make, op, cond) \
+  { \
+    Value rhs = pop(); \
+    Value lhs = pop(); \
+    if (lhs.isInt() && rhs.isInt() && (cond)) { \
+      push(Value::make(lhs.asInt() op rhs.asInt())); \
+      VM_NEXT(); \
+    } \
+    VM_SYNC(); \
+    if (binaryOp(opcode, lhs, rhs)) { \
+      VM_NEXT(); \
+    } \
+    static const Symbol methodSymbol(method); \
+    Ref<Object> self = lhs.box(); \
+    callMemberArgs(self, methodSymbol, {self, rhs.box()}, false); \
+    VM_NEXT_CALL(); \
+  }
+
+#define VM_BINARY_OP(opcode, method, make, op) VM_BINARY_OP_IF(opcode, method, make, op, true)
+#define VM_DIVISION_OP(opcode, method, op)     VM_BINARY_OP_IF(opcode, method, fromInt, op, rhs.asInt() != 0)
+
+/* ++/-- on a local variable, inline slots are updated in place */
+#define VM_INC_LOCAL(method, op) \
+  { \
+    uint32_t local = VM_READ(uint32_t); \
+    Value& slot = locals[local]; \
+    if (slot.isInt()) { \
+      Value old = slot; \
+      slot = Value::fromInt(slot.asInt() op 1); \
+      push(old); \
+      VM_NEXT(); \
+    } else if (slot.isFloat()) { \
+      Value old = slot; \
+      slot = Value::fromFloat(slot.asFloat() op 1); \
+      push(old); \
+      VM_NEXT(); \
+    } \
+    VM_SYNC(); \
+    slot.boxInPlace(); \
+    Ref<Object> self = slot.box(); \
+    callMemberArgs(self, method, {self}, false); \
+    VM_NEXT_CALL(); \
+  }
+
+template <typename T>
+static inline T readOperand(const uint8_t*& ip) {
+  T value;
+  memcpy(&value, ip, sizeof(T));
+  ip += sizeof(T);
+  return value;
+}
+
+void ff::VM::run() {
+  // Loop returns once the frame it was started for returns
+  const size_t entryDepth = m_callStack.size();
+  size_t depth = 0;
+  Code* code = nullptr;
+  const uint8_t* base = nullptr;
+  const uint8_t* ip = nullptr;
+  const uint32_t* globalSlots = nullptr;
+  // Value stack is preallocated, so frame's slots never move
+  Value* locals = nullptr;
+  VM_LOAD_FRAME();
+
+#ifdef _FF_THREADED_DISPATCH
+  static void* dispatchTable[] = {
+    &&L_OP_POP,         &&L_OP_PULL_UP,     &&L_OP_ROL,          &&L_OP_DUP,
+    &&L_OP_NULL,        &&L_OP_TRUE,        &&L_OP_FALSE,        &&L_OP_NEW,
+    &&L_OP_COPY,        &&L_OP_LOAD_CONSTANT, &&L_OP_NEW_GLOBAL, &&L_OP_GET_GLOBAL,
+    &&L_OP_SET_GLOBAL,  &&L_OP_SET_GLOBAL_REF, &&L_OP_GET_LOCAL, &&L_OP_SET_LOCAL,
+    &&L_OP_SET_LOCAL_REF, &&L_OP_REF_LOCAL, &&L_OP_GET_FIELD,    &&L_OP_SET_FIELD,
+    &&L_OP_SET_FIELD_REF, &&L_OP_GET_SLOT,  &&L_OP_SET_SLOT,     &&L_OP_GET_STATIC,
+    &&L_OP_JUMP,        &&L_OP_JUMP_TRUE,   &&L_OP_JUMP_FALSE,   &&L_OP_LOOP,
+    &&L_OP_CALL,        &&L_OP_CALL_MEMBER, &&L_OP_TAIL_CALL,    &&L_OP_RETURN,
+    &&L_OP_CAST,        &&L_OP_PRINT,       &&L_OP_ADD,          &&L_OP_SUB,
+    &&L_OP_MUL,         &&L_OP_DIV,         &&L_OP_MOD,          &&L_OP_EQ,
+    &&L_OP_NEQ,         &&L_OP_LT,          &&L_OP_GT,           &&L_OP_LE,
+    &&L_OP_GE,          &&L_OP_AND,         &&L_OP_OR,           &&L_OP_NEG,
+    &&L_OP_NOT,         &&L_OP_INC,         &&L_OP_DEC,          &&L_OP_INC_LOCAL,
+    &&L_OP_DEC_LOCAL,   &&L_OP_BREAKPOINT,  &&L_OP_HALT,
+  };
+  static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == OP_HALT + 1, "dispatchTable is out of sync with Opcode");
+
+  VM_DISPATCH();
+#else
+  Opcode op;
+dispatch:
+  op = (Opcode) *ip++;
   switch (op) {
-    case OP_POP: {
-      pop();
-      break;
-    }
-    case OP_PULL_UP: {
-      uint16_t index = getCode()->template read<uint16_t>();
-      Ref<Object> value = getStack()[getStack().size() - index];
-      getStack().getBuffer().erase(getStack().getBuffer().end() - index);
-      push(value);
-      break;
-    }
-    case OP_ROL: {
-      Ref<Object> a = pop();
-      Ref<Object> b = pop();
-      push(a);
-      push(b);
-      break;
-    }
-    case OP_DUP: {
-      push(getStack().peek());
-      break;
-    }
-    case OP_NULL: {
-      push(Ref<Object>());
-      break;
-    }
-    case OP_TRUE: {
-      push(Bool::createInstance(true).asRefTo<Object>());
-      break;
-    }
-    case OP_FALSE: {
-      push(Bool::createInstance(false).asRefTo<Object>());
-      break;
-    }
-    case OP_NEW: {
-      Ref<Class> class_ = popCheckType(ClassType::getInstance()).asRefTo<Class>();
-      push(ClassInstance::createInstance(class_).asRefTo<Object>());
-      break;
-    }
-    case OP_COPY: {
-      Ref<Object> object = pop();
-      callMember(object, "__copy__", 0);
-      break;
-    }
-    case OP_LOAD_CONSTANT: {
-      push(getCode()->getConstant(getCode()->read<uint32_t>()));
-      break;
-    }
-    case OP_NEW_GLOBAL: {
-      Ref<String> varName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      m_globals[varName->value] = {};
-      break;
-    }
-    case OP_GET_GLOBAL: {
-      Ref<String> varName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      if (m_globals.find(varName->value) == m_globals.end()) {
-        throw createError("Undefined variable '%s'", varName->value.c_str());
-      }
-      push(m_globals[varName->value]);
-      break;
+#endif
+
+  VM_CASE(OP_POP) {
+    pop();
+    VM_NEXT();
+  }
+  VM_CASE(OP_PULL_UP) {
+    uint16_t index = VM_READ(uint16_t);
+    Value value = std::move(m_stack[m_stack.size() - index]);
+    m_stack.erase(m_stack.size() - index);
+    push(std::move(value));
+    VM_NEXT();
+  }
+  VM_CASE(OP_ROL) {
+    Value a = pop();
+    Value b = pop();
+    push(a);
+    push(b);
+    VM_NEXT();
+  }
+  VM_CASE(OP_DUP) {
+    push(getStack().peek());
+    VM_NEXT();
+  }
+  VM_CASE(OP_NULL) {
+    push(Value());
+    VM_NEXT();
+  }
+  VM_CASE(OP_TRUE) {
+    push(Value::fromBool(true));
+    VM_NEXT();
+  }
+  VM_CASE(OP_FALSE) {
+    push(Value::fromBool(false));
+    VM_NEXT();
+  }
+  VM_CASE(OP_NEW) {
+    VM_SYNC();
+    Ref<Class> class_ = popCheckType(ClassType::getInstance()).asRefTo<Class>();
+    push(ClassInstance::createInstance(class_).asRefTo<Object>());
+    VM_NEXT();
+  }
+  VM_CASE(OP_COPY) {
+    // Inline values are copies already, boxed int/float/bool are copied inline
+    Value& top = getStack().peek();
+    if (top.isInline()) {
+      VM_NEXT();
     }
-    case OP_SET_GLOBAL: {
-      Ref<String> varName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      if (m_globals.find(varName->value) == m_globals.end()) {
-        throw createError("Undefined variable '%s'", varName->value.c_str());
+    if (top.isObject()) {
+      Value value = Value::unbox(top.asObject());
+      if (value.isInline()) {
+        top = value;
+        VM_NEXT();
       }
-      m_globals[varName->value] = pop();
-      break;
     }
-    case OP_SET_GLOBAL_REF: {
-      Ref<String> varName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      if (m_globals.find(varName->value) == m_globals.end()) {
-        throw createError("Undefined variable '%s'", varName->value.c_str());
-      }
-      Ref<Object> self = m_globals[varName->value];
-      callMember(self, "__assign__", {self, pop()});
-      pop();
-      break;
-    }
-    case OP_GET_LOCAL: {
-      uint32_t local = getCode()->template read<uint32_t>();
-      push(getStack()[local]); // frame?
-      break;
-    }
-    case OP_SET_LOCAL: {
-      uint32_t local = getCode()->template read<uint32_t>();
-      getStack()[local] = pop();
-      break;
-    }
-    case OP_SET_LOCAL_REF: {
-      uint32_t local = getCode()->template read<uint32_t>();
-      Ref<Object> self = getStack()[local];
-      callMember(self, "__assign__", {self, pop()});
-      pop();
-      break;
-    }
-    case OP_GET_FIELD: {
-      Ref<String> fieldName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      Ref<Object> object = pop();
-      push(object->getField(fieldName->value));
-      break;
-    }
-    case OP_SET_FIELD: { // [ name, obj, value ]
-      Ref<String> fieldName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      Ref<Object> object = pop();
-      Ref<Object> value = pop();
-      object->setField(fieldName->value, value);
-      break;
-    }
-    case OP_SET_FIELD_REF: { // [ name, obj, value ]
-      Ref<String> fieldName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      Ref<Object> object = pop();
-      Ref<Object> value = pop();
-      Ref<Object> self = object->getField(fieldName->value);
-      callMember(self, "__assign__", {self, value});
-      pop();
-      break;
-    }
-    case OP_GET_STATIC: {
-      throw createError("OP_GET_STATIC: Unimplemented");
-    }
-    case OP_JUMP: {
-      uint16_t offset = getCode()->template read<uint16_t>();
-      getCode()->setReadIndex(getCode()->getReadIndex() + offset);
-      break;
-    }
-    case OP_JUMP_TRUE: {
-      uint16_t offset = getCode()->template read<uint16_t>();
-      Ref<Object> object = pop();
-      bool result = false;
-      if (object.get()) {
-        if (object->isType() && object.as<Type>()->getTypeName() != "null") {
-          result = true;
-        } else if (isOfType(object, BoolType::getInstance())) {
-          result = object.as<Bool>()->value;
-        } else {
-          callMember(object, "__bool__", 0);
-          result = popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
-        }
-      }
-      if (result) {
-        getCode()->setReadIndex(getCode()->getReadIndex() + offset);
+    VM_SYNC();
+    g_copyCount++;
+    Ref<Object> object = pop().box();
+    bool implicitSelf = true;
+    Ref<Object> member = findMember(object, kCopyMethod, implicitSelf);
+    callFoundMember(object, kCopyMethod, member, implicitSelf, 0, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_LOAD_CONSTANT) {
+    push(Value::unbox(code->getConstant(VM_READ(uint32_t))));
+    VM_NEXT();
+  }
+  VM_CASE(OP_NEW_GLOBAL) {
+    Global& global = getGlobalSlot(VM_READ_GLOBAL());
+    global.value = {};
+    global.isDefined = true;
+    VM_NEXT();
+  }
+  VM_CASE(OP_GET_GLOBAL) {
+    uint32_t slot = VM_READ_GLOBAL();
+    if (slot >= m_globals.size() || !m_globals[slot].isDefined) {
+      VM_SYNC();
+      throw createError("Undefined variable '%s'", globals::getName(slot).c_str());
+    }
+    push(m_globals[slot].value);
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_GLOBAL) {
+    uint32_t slot = VM_READ_GLOBAL();
+    if (slot >= m_globals.size() || !m_globals[slot].isDefined) {
+      VM_SYNC();
+      throw createError("Undefined variable '%s'", globals::getName(slot).c_str());
+    }
+    m_globals[slot].value = pop().box();
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_GLOBAL_REF) {
+    uint32_t slot = VM_READ_GLOBAL();
+    VM_SYNC();
+    if (slot >= m_globals.size() || !m_globals[slot].isDefined) {
+      throw createError("Undefined variable '%s'", globals::getName(slot).c_str());
+    }
+    Ref<Object> self = m_globals[slot].value;
+    callMember(self, kAssignMethod, {self, pop().box()});
+    pop();
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_GET_LOCAL) {
+    uint32_t local = VM_READ(uint32_t);
+    push(locals[local]);
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_LOCAL) {
+    uint32_t local = VM_READ(uint32_t);
+    locals[local] = pop();
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_LOCAL_REF) {
+    uint32_t local = VM_READ(uint32_t);
+    Value value = pop();
+    Value& slot = locals[local];
+    // Inline local can't be aliased, so the value can be replaced directly
+    if (slot.isInline() && slot.getTag() == value.getTag()) {
+      slot = value;
+      VM_NEXT();
+    }
+    VM_SYNC();
+    slot.boxInPlace();
+    Ref<Object> self = slot.box();
+    callMember(self, kAssignMethod, {self, value.box()});
+    pop();
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_REF_LOCAL) {
+    uint32_t local = VM_READ(uint32_t);
+    locals[local].boxInPlace();
+    push(locals[local]);
+    VM_NEXT();
+  }
+  VM_CASE(OP_GET_FIELD) {
+    uint32_t name = VM_READ(uint32_t);
+    InlineCache& cache = code->getInlineCache(VM_READ(uint32_t));
+    Ref<Object> object = pop().box();
+    if (ClassInstance* instance = asClassInstance(object)) {
+      InlineCache::Entry* entry = cache.findSlot(instance->getClass().get());
+      if (entry && entry->slot < instance->getSlotCount()) {
+        push(instance->getSlot(entry->slot));
+        VM_NEXT();
       }
-      break;
-    }
-    case OP_JUMP_FALSE: {
-      uint16_t offset = getCode()->template read<uint16_t>();
-      Ref<Object> object = pop();
-      bool result = false;
-      if (object.get()) {
-        if (object->isType() && object.as<Type>()->getTypeName() != "null") {
-          result = true;
-        } else if (isOfType(object, BoolType::getInstance())) {
-          result = object.as<Bool>()->value;
-        } else {
-          callMember(object, "__bool__", 0);
-          result = popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
-        }
+    } else if (object.get()) {
+      if (InlineCache::Entry* entry = cache.find(object.get())) {
+        push(entry->member);
+        VM_NEXT();
       }
-      if (!result) {
-        getCode()->setReadIndex(getCode()->getReadIndex() + offset);
+    }
+    VM_SYNC();
+    push(getField(object, code->getSymbol(name), cache, InlineCache::kNoSlot));
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_FIELD) { // [ obj, value ]
+    uint32_t name = VM_READ(uint32_t);
+    VM_SYNC();
+    Ref<Object> object = pop().box();
+    Value value = pop();
+    object->setField(code->getSymbol(name), value.box());
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_FIELD_REF) { // [ obj, value ]
+    uint32_t name = VM_READ(uint32_t);
+    VM_SYNC();
+    Ref<Object> object = pop().box();
+    Value value = pop();
+    Ref<Object> self = object->getField(code->getSymbol(name));
+    callMember(self, kAssignMethod, {self, value.box()});
+    pop();
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_GET_SLOT) {
+    uint32_t slot = VM_READ(uint32_t);
+    uint32_t name = VM_READ(uint32_t);
+    InlineCache& cache = code->getInlineCache(VM_READ(uint32_t));
+    Ref<Object> object = pop().box();
+    // Slot is only cached for a class once it was checked to be the slot of the field
+    if (ClassInstance* instance = asClassInstance(object)) {
+      if (slot < instance->getSlotCount() && cache.findSlot(instance->getClass().get())) {
+        push(instance->getSlot(slot));
+        VM_NEXT();
       }
-      break;
-    }
-    case OP_LOOP: {
-      uint16_t offset = getCode()->template read<uint16_t>();
-      getCode()->setReadIndex(getCode()->getReadIndex() - offset);
-      break;
-    }
-    case OP_CALL: {
-      Ref<Object> fn = pop();
-      int argc = popCheckType(IntType::getInstance()).asRefTo<Int>()->value;
-      call(fn, argc);
-      break;
-    }
-    case OP_CALL_MEMBER: {
-      Ref<String> memberName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      Ref<Object> object = pop();
-      callMember(object, memberName->value, popCheckType(IntType::getInstance()).asRefTo<Int>()->value);
-      break;
-    }
-    case OP_RETURN: {
-      auto result = returnCall();
-      push(result);
-      return false;
     }
-    case OP_CAST: {
-      Ref<String> typeName = popCheckType(StringType::getInstance()).asRefTo<String>();
-      Ref<Object> object = pop();
-      push(Object::cast(this, object, typeName->value));
-      break;
-    }
-    case OP_PRINT: {
-      Ref<Object> value = pop();
-      printf("%s\n", value.get() ? value->toString().c_str() : "null");
-      break;
-    }
-    case OP_ADD: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__add__", {lhs, rhs});
-      break;
-    }
-    case OP_SUB: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__sub__", {lhs, rhs});
-      break;
-    }
-    case OP_MUL: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__mul__", {lhs, rhs});
-      break;
-    }
-    case OP_DIV: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__div__", {lhs, rhs});
-      break;
-    }
-    case OP_MOD: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__mod__", {lhs, rhs});
-      break;
-    }
-    case OP_EQ: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__eq__", {lhs, rhs});
-      break;
-    }
-    case OP_NEQ: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__neq__", {lhs, rhs});
-      break;
-    }
-    case OP_LT: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__lt__", {lhs, rhs});
-      break;
-    }
-    case OP_GT: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__gt__", {lhs, rhs});
-      break;
-    }
-    case OP_LE: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__le__", {lhs, rhs});
-      break;
-    }
-    case OP_GE: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-      callMember(lhs, "__ge__", {lhs, rhs});
-      break;
-    }
-    case OP_AND: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
-
-      bool result;
-      if (isOfType(lhs, BoolType::getInstance())) {
-        result = lhs.as<Bool>()->value;
-      } else {
-        callMember(lhs, "__bool__", 0);
-        result = popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
+    VM_SYNC();
+    push(getField(object, code->getSymbol(name), cache, slot));
+    VM_NEXT();
+  }
+  VM_CASE(OP_SET_SLOT) { // [ obj, value ]
+    uint32_t slot = VM_READ(uint32_t);
+    uint32_t name = VM_READ(uint32_t);
+    InlineCache& cache = code->getInlineCache(VM_READ(uint32_t));
+    Ref<Object> object = pop().box();
+    Value value = pop();
+    if (ClassInstance* instance = asClassInstance(object)) {
+      if (slot < instance->getSlotCount() && !instance->isImmortal() && cache.findSlot(instance->getClass().get())) {
+        instance->setSlot(slot, value.box());
+        VM_NEXT();
       }
-
-      if (isOfType(rhs, BoolType::getInstance())) {
-        result = rhs.as<Bool>()->value;
-      } else {
-        callMember(rhs, "__bool__", 0);
-        result = result && popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
+    }
+    VM_SYNC();
+    setField(object, code->getSymbol(name), value.box(), cache, slot);
+    VM_NEXT();
+  }
+  VM_CASE(OP_GET_STATIC) {
+    VM_SYNC();
+    throw createError("OP_GET_STATIC: Unimplemented");
+  }
+  VM_CASE(OP_JUMP) {
+    uint16_t offset = VM_READ(uint16_t);
+    ip += offset;
+    VM_NEXT();
+  }
+  VM_CASE(OP_JUMP_TRUE) {
+    uint16_t offset = VM_READ(uint16_t);
+    VM_SYNC();
+    if (isTruthy(pop())) {
+      ip += offset;
+    }
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_JUMP_FALSE) {
+    uint16_t offset = VM_READ(uint16_t);
+    VM_SYNC();
+    if (!isTruthy(pop())) {
+      ip += offset;
+    }
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_LOOP) {
+    uint16_t offset = VM_READ(uint16_t);
+    ip -= offset;
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_CALL) {
+    VM_SYNC();
+    Ref<Object> fn = pop().box();
+    int argc = popArgc();
+    callObject(fn, argc, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_CALL_MEMBER) {
+    uint32_t name = VM_READ(uint32_t);
+    InlineCache& cache = code->getInlineCache(VM_READ(uint32_t));
+    VM_SYNC();
+    Ref<Object> object = pop().box();
+    int argc = popArgc();
+    const Symbol& memberName = code->getSymbol(name);
+    InlineCache::Entry* entry = object.get() ? cache.find(getMemberReceiver(object.get())) : nullptr;
+    if (entry) {
+      Ref<Object> member = entry->member;
+      callFoundMember(object, memberName, member, entry->implicitSelf, argc, false);
+    } else {
+      bool implicitSelf = true;
+      Ref<Object> member = findMember(object, memberName, implicitSelf, &cache.replace());
+      callFoundMember(object, memberName, member, implicitSelf, argc, false);
+    }
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_TAIL_CALL) {
+    VM_SYNC();
+    Ref<Object> fn = pop().box();
+    int argc = popArgc();
+    if (fn.get() && isOfType(fn, FunctionType::getInstance())) {
+      if (fn.as<Function>()->args.size() != argc) {
+        throw createError("Expected %d arguments, but got %d", fn.as<Function>()->args.size(), argc);
       }
+      replaceFrame(fn.as<Function>()->code, argc);
+      VM_LOAD_FRAME();
+      VM_NEXT_CALL();
+    }
+    // Native functions (and errors) are handled the same as OP_CALL followed by OP_RETURN
+    callObject(fn, argc, true);
+    VM_RETURN();
+  }
+  VM_CASE(OP_RETURN) {
+    VM_SYNC();
+    VM_RETURN();
+  }
+  VM_CASE(OP_CAST) {
+    VM_SYNC();
+    Ref<String> typeName = popCheckType(StringType::getInstance()).asRefTo<String>();
+    Ref<Object> object = pop().box();
+    push(Object::cast(this, object, typeName->value));
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_PRINT) {
+    Value value = pop();
+    printf("%s\n", value.toString().c_str());
+    VM_NEXT();
+  }
+  VM_CASE(OP_ADD) VM_BINARY_OP(OP_ADD, "__add__", fromInt, +);
+  VM_CASE(OP_SUB) VM_BINARY_OP(OP_SUB, "__sub__", fromInt, -);
+  VM_CASE(OP_MUL) VM_BINARY_OP(OP_MUL, "__mul__", fromInt, *);
+  VM_CASE(OP_DIV) VM_DIVISION_OP(OP_DIV, "__div__", /);
+  VM_CASE(OP_MOD) VM_DIVISION_OP(OP_MOD, "__mod__", %);
+  VM_CASE(OP_EQ)  VM_BINARY_OP(OP_EQ,  "__eq__",  fromBool, ==);
+  VM_CASE(OP_NEQ) VM_BINARY_OP(OP_NEQ, "__neq__", fromBool, !=);
+  VM_CASE(OP_LT)  VM_BINARY_OP(OP_LT,  "__lt__",  fromBool, <);
+  VM_CASE(OP_GT)  VM_BINARY_OP(OP_GT,  "__gt__",  fromBool, >);
+  VM_CASE(OP_LE)  VM_BINARY_OP(OP_LE,  "__le__",  fromBool, <=);
+  VM_CASE(OP_GE)  VM_BINARY_OP(OP_GE,  "__ge__",  fromBool, >=);
+  VM_CASE(OP_AND) {
+    VM_SYNC();
+    Value rhs = pop();
+    Value lhs = pop();
 
-      push(Bool::createInstance(result).asRefTo<Object>());
-      break;
+    bool result = toBool(lhs);
+    if (rhs.isBool() || (rhs.isObject() && isOfType(rhs.asObject(), BoolType::getInstance()))) {
+      result = toBool(rhs);
+    } else {
+      result = result && toBool(rhs);
     }
-    case OP_OR: {
-      Ref<Object> rhs = pop();
-      Ref<Object> lhs = pop();
 
-      bool result;
-      if (isOfType(lhs, BoolType::getInstance())) {
-        result = lhs.as<Bool>()->value;
-      } else {
-        callMember(lhs, "__bool__", 0);
-        result = popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
-      }
+    push(Value::fromBool(result));
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_OR) {
+    VM_SYNC();
+    Value rhs = pop();
+    Value lhs = pop();
 
-      if (isOfType(rhs, BoolType::getInstance())) {
-        result = result || rhs.as<Bool>()->value;
-      } else {
-        callMember(rhs, "__bool__", 0);
-        result = result || popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
-      }
+    bool result = toBool(lhs);
+    result = result || toBool(rhs);
 
-      push(Bool::createInstance(result).asRefTo<Object>());
-      break;
+    push(Value::fromBool(result));
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_NOT) {
+    VM_SYNC();
+    Value operand = pop();
+    if (operand.isInline()) {
+      push(Value::fromBool(!toBool(operand)));
+      VM_NEXT();
     }
-    case OP_NOT: {
-      Ref<Object> operand = pop();
-      if (!isOfType(operand, BoolType::getInstance())) {
-        callMember(operand, "__bool__", 0);
-        operand = popCheckType(BoolType::getInstance());
-      }
-      callMember(operand, "__not__", {operand});
-      break;
+    Ref<Object> object = operand.box();
+    if (!isOfType(object, BoolType::getInstance())) {
+      callMember(object, kBoolMethod, 0);
+      object = popCheckType(BoolType::getInstance());
     }
-    case OP_NEG: {
-      Ref<Object> operand = pop();
-      callMember(operand, "__neg__", {operand});
-      break;
+    callMemberArgs(object, kNotMethod, {object}, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_NEG) {
+    Value operand = pop();
+    if (operand.isInt()) {
+      push(Value::fromInt(-operand.asInt()));
+      VM_NEXT();
+    } else if (operand.isFloat()) {
+      push(Value::fromFloat(-operand.asFloat()));
+      VM_NEXT();
     }
-    case OP_INC: {
-      Ref<Object> operand = pop();
-      callMember(operand, "__inc__", {operand});
-      break;
+    VM_SYNC();
+    Ref<Object> object = operand.box();
+    callMemberArgs(object, kNegMethod, {object}, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_INC) {
+    // Incrementing a temporary has no visible effect, result is the old value
+    if (getStack().peek().isInt() || getStack().peek().isFloat()) {
+      VM_NEXT();
     }
-    case OP_DEC: {
-      Ref<Object> operand = pop();
-      callMember(operand, "__dec__", {operand});
-      break;
+    VM_SYNC();
+    Ref<Object> operand = pop().box();
+    callMemberArgs(operand, kIncMethod, {operand}, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_DEC) {
+    if (getStack().peek().isInt() || getStack().peek().isFloat()) {
+      VM_NEXT();
     }
-    case OP_BREAKPOINT: {
+    VM_SYNC();
+    Ref<Object> operand = pop().box();
+    callMemberArgs(operand, kDecMethod, {operand}, false);
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_INC_LOCAL) VM_INC_LOCAL(kIncMethod, +);
+  VM_CASE(OP_DEC_LOCAL) VM_INC_LOCAL(kDecMethod, -);
+  VM_CASE(OP_BREAKPOINT) {
+    VM_SYNC();
 #ifdef _DEBUG
-      runtimeBreakpoint();
+    runtimeBreakpoint();
+    ip = base + code->getReadIndex();
 #else
-      throw createError("Breakpoints are not supported in release builds (compile with -p debug)");
+    throw createError("Breakpoints are not supported in release builds (compile with -p debug)");
 #endif
-      break;
-    }
-    default:
+    VM_NEXT_CALL();
+  }
+  VM_CASE(OP_HALT) {
+    VM_SYNC();
+    return;
+  }
+#ifndef _FF_THREADED_DISPATCH
+    default: {
+      VM_SYNC();
       throw createError("Unknown Instruction 0x%x", op);
+    }
   }
+#endif
+}
 
-#ifdef _FF_DEBUG_TRACE
-  if (config::get("debug") != "0") {
-    printf("     ");
-    printStack();
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_NEXT
+#undef VM_SYNC
+#undef VM_CHECK_STOP
+#undef VM_NEXT_CALL
+#undef VM_LOAD_FRAME
+#undef VM_RETURN
+#undef VM_READ
+#undef VM_BINARY_OP_IF
+#undef VM_BINARY_OP
+#undef VM_DIVISION_OP
+#undef VM_INC_LOCAL
+#undef VM_TRACE_BEFORE
+#undef VM_TRACE_AFTER
+
+bool ff::VM::isTruthy(const Value& value) {
+  switch (value.getTag()) {
+    case Value::VTAG_NULL:   return false;
+    case Value::VTAG_INT:    return value.asInt() != 0;
+    case Value::VTAG_FLOAT:  return value.asFloat() != 0;
+    case Value::VTAG_BOOL:   return value.asBool();
+    default:                 return Object::toBool(this, value.asObject());
   }
-#endif
+}
 
-  return true;
+bool ff::VM::toBool(const Value& value) {
+  switch (value.getTag()) {
+    case Value::VTAG_INT:    return value.asInt() != 0;
+    case Value::VTAG_FLOAT:  return value.asFloat() != 0;
+    case Value::VTAG_BOOL:   return value.asBool();
+    default: {
+      Ref<Object> object = value.box();
+      if (isOfType(object, BoolType::getInstance())) {
+        return object.as<Bool>()->value;
+      }
+      callMember(object, kBoolMethod, 0);
+      return popCheckType(BoolType::getInstance()).asRefTo<Bool>()->value;
+    }
+  }
 }
 
-void ff::VM::printStack() {
-  printf("[");
-  for (int i = 0; i < getStack().size(); i++) {
-    printf("%s", getStack()[i].get() ? getStack()[i]->toString().c_str() : "<null>");
-    if (i + 1 < getStack().size()) printf(", ");
+int ff::VM::popArgc() {
+  Value argc = pop();
+  if (!argc.isInt()) {
+    throw createError("TypeMismatch: expected 'int' as argument count");
+  }
+  return argc.asInt();
+}
+
+/* Computes operators of built-in types (same semantics as their operator methods) and pushes the result
+ * Returns false if operands aren't handled here, so caller falls back to the operator method
+ */
+bool ff::VM::binaryOp(Opcode op, const Value& lhs, const Value& rhs) {
+  Operand a = toOperand(lhs);
+  Operand b = toOperand(rhs);
+
+  switch (a.kind) {
+    case Operand::INT: {
+      int64_t other;
+      if (b.kind == Operand::INT) {
+        other = b.i;
+      } else if (b.kind == Operand::FLOAT) {
+        other = (int64_t) b.f;
+      } else {
+        return false;
+      }
+      switch (op) {
+        case OP_ADD: push(Value::fromInt(a.i + other)); return true;
+        case OP_SUB: push(Value::fromInt(a.i - other)); return true;
+        case OP_MUL: push(Value::fromInt(a.i * other)); return true;
+        case OP_DIV:
+        case OP_MOD:
+          if (other == 0) {
+            throw createError("Division by zero");
+          }
+          push(Value::fromInt(op == OP_DIV ? a.i / other : a.i % other));
+          return true;
+        case OP_EQ:  push(Value::fromBool(a.i == other)); return true;
+        case OP_NEQ: push(Value::fromBool(a.i != other)); return true;
+        case OP_LT:  push(Value::fromBool(a.i <  other)); return true;
+        case OP_GT:  push(Value::fromBool(a.i >  other)); return true;
+        case OP_LE:  push(Value::fromBool(a.i <= other)); return true;
+        case OP_GE:  push(Value::fromBool(a.i >= other)); return true;
+        default:     return false;
+      }
+    }
+
+    case Operand::FLOAT: {
+      double other;
+      if (b.kind == Operand::FLOAT) {
+        other = b.f;
+      } else if (b.kind == Operand::INT) {
+        other = b.i;
+      } else {
+        return false;
+      }
+      switch (op) {
+        case OP_ADD: push(Value::fromFloat(a.f + other)); return true;
+        case OP_SUB: push(Value::fromFloat(a.f - other)); return true;
+        case OP_MUL: push(Value::fromFloat(a.f * other)); return true;
+        case OP_DIV: push(Value::fromFloat(a.f / other)); return true;
+        case OP_EQ:  push(Value::fromBool(a.f == other)); return true;
+        case OP_NEQ: push(Value::fromBool(a.f != other)); return true;
+        case OP_LT:  push(Value::fromBool(a.f <  other)); return true;
+        case OP_GT:  push(Value::fromBool(a.f >  other)); return true;
+        case OP_LE:  push(Value::fromBool(a.f <= other)); return true;
+        case OP_GE:  push(Value::fromBool(a.f >= other)); return true;
+        default:     return false;
+      }
+    }
+
+    case Operand::BOOL: {
+      if (b.kind != Operand::BOOL) {
+        return false;
+      }
+      switch (op) {
+        case OP_EQ:  push(Value::fromBool(a.b == b.b)); return true;
+        case OP_NEQ: push(Value::fromBool(a.b != b.b)); return true;
+        default:     return false;
+      }
+    }
+
+    case Operand::STRING: {
+      if (op == OP_ADD) {
+        switch (b.kind) {
+          case Operand::STRING: push(String::createInstance(*a.s + *b.s).asRefTo<Object>()); return true;
+          case Operand::INT:    push(String::createInstance(*a.s + std::to_string(b.i)).asRefTo<Object>()); return true;
+          case Operand::FLOAT:  push(String::createInstance(*a.s + std::to_string(b.f)).asRefTo<Object>()); return true;
+          case Operand::BOOL:   push(String::createInstance(*a.s + (b.b ? "true" : "false")).asRefTo<Object>()); return true;
+          case Operand::NUL:    push(String::createInstance(*a.s + "null").asRefTo<Object>()); return true;
+          default:              return false;
+        }
+      }
+      if (b.kind != Operand::STRING) {
+        return false;
+      }
+      switch (op) {
+        case OP_EQ:  push(Value::fromBool(*a.s == *b.s)); return true;
+        case OP_NEQ: push(Value::fromBool(*a.s != *b.s)); return true;
+        default:     return false;
+      }
+    }
+
+    default:
+      return false;
   }
-  printf("]\n");
 }
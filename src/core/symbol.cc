@@ -0,0 +1,64 @@
+#include <ff/symbol.h>
+#include <unordered_map>
+#include <string_view>
+#include <shared_mutex>
+#include <mutex>
+#include <deque>
+
+struct ff::Symbol::Table {
+  std::shared_mutex mutex; // Most names are already interned, so lookups only take a shared lock
+  std::unordered_map<std::string_view, const Entry*> entries; // Keys point into names of entries
+  std::deque<Entry> storage; // Deque, so entries never move
+};
+
+ff::Symbol::Symbol() {
+  static const Entry* empty = intern("");
+  m_entry = empty;
+}
+
+ff::Symbol::Symbol(const std::string& name) : m_entry(intern(name)) {}
+
+ff::Symbol::Symbol(const char* name) : m_entry(intern(name)) {}
+
+ff::Symbol::Symbol(const Entry* entry) : m_entry(entry) {}
+
+bool ff::Symbol::operator<(const Symbol& rhs) const {
+  return m_entry != rhs.m_entry && m_entry->name < rhs.m_entry->name;
+}
+
+bool ff::Symbol::find(const std::string& name, Symbol& symbol) {
+  Table& table = getTable();
+  std::shared_lock<std::shared_mutex> lock(table.mutex);
+  auto itr = table.entries.find(name);
+  if (itr == table.entries.end()) {
+    return false;
+  }
+  symbol = Symbol(itr->second);
+  return true;
+}
+
+ff::Symbol::Table& ff::Symbol::getTable() {
+  // Constructed on first use, symbols are made by static initializers of other files
+  static Table table;
+  return table;
+}
+
+const ff::Symbol::Entry* ff::Symbol::intern(const std::string& name) {
+  Table& table = getTable();
+  {
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto itr = table.entries.find(name);
+    if (itr != table.entries.end()) {
+      return itr->second;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(table.mutex);
+  auto itr = table.entries.find(name); // Another isolate may have interned it in the meantime
+  if (itr != table.entries.end()) {
+    return itr->second;
+  }
+  const Entry* entry = &table.storage.emplace_back(Entry {name, std::hash<std::string>()(name)});
+  table.entries.emplace(entry->name, entry);
+  return entry;
+}
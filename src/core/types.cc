@@ -44,6 +44,10 @@ ff::Ref<ff::NativeFunction> ff::types::fn(NativeFunction::ValueType func, const
   return NativeFunction::createInstance(func, args, returnType);
 }
 
+ff::Ref<ff::NativeFunction> ff::types::fn(NativeFunction::FastType func, const std::vector<Function::Argument>& args, ff::Ref<TypeAnnotation> returnType) {
+  return NativeFunction::createInstance(func, args, returnType);
+}
+
 ff::Ref<ff::NativeFunction> ff::types::nativefn(Ref<Object> object) {
   return object.asRefTo<NativeFunction>();
 }
@@ -129,11 +133,11 @@ bool& ff::types::boolval(Ref<Object> object) {
 }
 
 ff::Vector::ValueType& ff::types::vectorval(Ref<Vector> value) {
-  return value->value;
+  return value->value.getMutable();
 }
 
 ff::Vector::ValueType& ff::types::vectorval(Ref<Object> object) {
-  return vector(object)->value;
+  return vector(object)->value.getMutable();
 }
 
 ff::Dict::ValueType& ff::types::dictval(Ref<Dict> value) {
@@ -8,9 +8,9 @@ using namespace ff::types;
 
 ff::Ref<ff::BoolType> ff::BoolType::m_instance;
 
-ff::BoolType::BoolType() : Type("bool") {
+ff::BoolType::BoolType() : Type("bool", TYPEID_BOOL) {
   setField("__not__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(!boolval(args[0])));
     }, {
       {"self", type("bool")}
@@ -18,7 +18,7 @@ ff::BoolType::BoolType() : Type("bool") {
   );
 
   setField("__eq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(boolval(args[0]) == boolval(args[1])));
     }, {
       {"self", type("bool")},
@@ -27,7 +27,7 @@ ff::BoolType::BoolType() : Type("bool") {
   );
 
   setField("__neq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(boolval(args[0]) != boolval(args[1])));
     }, {
       {"self", type("bool")},
@@ -36,7 +36,7 @@ ff::BoolType::BoolType() : Type("bool") {
   );
 
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(boolval(args[0]) ? "true" : "false"));
     }, {
       {"self", type("bool")}
@@ -44,7 +44,7 @@ ff::BoolType::BoolType() : Type("bool") {
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(boolval(args[0])));
     }, {
       {"self", type("bool")}
@@ -52,7 +52,7 @@ ff::BoolType::BoolType() : Type("bool") {
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       boolval(args[0]) = boolval(args[1]);
       return Ref<Object>();
     }, {
@@ -70,8 +70,7 @@ std::string ff::BoolType::toString() const {
 
 ff::Ref<ff::BoolType> ff::BoolType::getInstance() {
     if (!m_instance.get()) {
-    m_instance = memory::allocate<BoolType>();
-    new (m_instance.get()) BoolType();
+    m_instance = Ref<BoolType>(new (memory::raw::allocate<BoolType>()) BoolType());
   }
   return m_instance;
 }
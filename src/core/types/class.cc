@@ -1,6 +1,7 @@
 #include <ff/types/class.h>
 #include <ff/types/string.h>
 #include <ff/utils/macros.h>
+#include <ff/errors.h>
 #include <ff/runtime.h>
 #include <ff/memory.h>
 #include <ff/types.h>
@@ -11,14 +12,14 @@ using namespace ff::types;
 ff::Ref<ff::ClassType> ff::ClassType::m_instance;
 ff::Ref<ff::ClassInstanceType> ff::ClassInstanceType::m_instance;
 
-ff::ClassType::ClassType() : Type("type") {
+ff::ClassType::ClassType() : Type("type", TYPEID_CLASS) {
   setField("addField", 
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      args[0].as<Class>()->fieldInfo[strval(args[1])] = Class::Field {
+    obj(fn([](VM* context, NativeArgs args) {
+      args[0].as<Class>()->addField(Class::Field {
         strval(args[1]),
         false,
         args[2]
-      };
+      });
       return Ref<Object>();
     }, {
       {"self", type("type")},
@@ -28,7 +29,7 @@ ff::ClassType::ClassType() : Type("type") {
   );
 
   setField("addMethod", 
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       args[0].as<Class>()->setField(strval(args[1]), args[2]);
       return Ref<Object>();
     }, {
@@ -47,8 +48,7 @@ std::string ff::ClassType::toString() const {
 
 ff::Ref<ff::ClassType> ff::ClassType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<ClassType>();
-    new (m_instance.get()) ClassType();
+    m_instance = Ref<ClassType>(new (memory::raw::allocate<ClassType>()) ClassType());
   }
   return m_instance;
 }
@@ -57,10 +57,13 @@ ff::Class::Class(const std::string& className)
   : Class(className, {}, {}) {}
 
 ff::Class::Class(const std::string& className, const std::unordered_map<std::string, Field>& fieldInfo, const std::unordered_map<std::string, Ref<Object>>& methods)
-    : Instance(ClassType::getInstance().asRefTo<Type>()), className(className), fieldInfo(fieldInfo) {
+    : Instance(ClassType::getInstance().asRefTo<Type>()), className(className) {
+  for (auto& [fieldName, field] : fieldInfo) {
+    addField(field);
+  }
 
   setField("__init__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return Ref<Object>();
     }, {
       {"self", any()}
@@ -68,7 +71,7 @@ ff::Class::Class(const std::string& className, const std::unordered_map<std::str
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return args[0];
     }, {
       {"self", any()}
@@ -82,6 +85,26 @@ ff::Class::Class(const std::string& className, const std::unordered_map<std::str
 
 ff::Class::~Class() {}
 
+void ff::Class::addField(const Field& field) {
+  fieldInfo[field.name] = field;
+  if (field.isStatic) {
+    return;
+  }
+  auto itr = shape.slots.find(field.name);
+  if (itr != shape.slots.end()) {
+    shape.initialValues[itr->second] = field.initialValue;
+    return;
+  }
+  shape.slots[field.name] = shape.names.size();
+  shape.names.push_back(field.name);
+  shape.initialValues.push_back(field.initialValue);
+}
+
+int ff::Class::findSlot(const Symbol& name) const {
+  auto itr = shape.slots.find(name);
+  return itr != shape.slots.end() ? (int) itr->second : -1;
+}
+
 std::string ff::Class::toString() const {
   return className;
 }
@@ -98,7 +121,7 @@ ff::Ref<ff::Class> ff::Class::createInstance(const std::string& className, const
   return memory::construct<Class>(className, fieldInfo, methods);
 }
 
-ff::ClassInstanceType::ClassInstanceType() : Type("instance") {
+ff::ClassInstanceType::ClassInstanceType() : Type("instance", TYPEID_CLASS_INSTANCE) {
   //
 }
 
@@ -110,31 +133,45 @@ std::string ff::ClassInstanceType::toString() const {
 
 ff::Ref<ff::ClassInstanceType> ff::ClassInstanceType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<ClassInstanceType>();
-    new (m_instance.get()) ClassInstanceType();
+    m_instance = Ref<ClassInstanceType>(new (memory::raw::allocate<ClassInstanceType>()) ClassInstanceType());
   }
   return m_instance;
 }
 
-ff::ClassInstance::ClassInstance(Ref<Class> class_) : Instance(ClassInstanceType::getInstance().asRefTo<Type>()), m_class(class_) {
-  for (auto& [fieldName, fieldInfo] : getClass()->fieldInfo) {
-    if (fieldInfo.isStatic) {
-      continue;
-    }
-    if (fieldInfo.initialValue.get()) {
-      setField(fieldName, fieldInfo.initialValue);
-    } else {
-      setField(fieldName, Ref<Object>());
-    }
-  }
-}
+ff::ClassInstance::ClassInstance(Ref<Class> class_)
+  : Instance(ClassInstanceType::getInstance().asRefTo<Type>()), m_class(class_), m_slots(class_->shape.initialValues) {}
 
 ff::ClassInstance::~ClassInstance() {}
 
-ff::Ref<ff::Class> ff::ClassInstance::getClass() const {
+const ff::Ref<ff::Class>& ff::ClassInstance::getClass() const {
   return m_class;
 }
 
+bool ff::ClassInstance::hasField(const Symbol& key) const {
+  int slot = m_class->findSlot(key);
+  return (slot >= 0 && slot < m_slots.size()) || Object::hasField(key);
+}
+
+ff::Ref<ff::Object> ff::ClassInstance::getField(const Symbol& key) {
+  int slot = m_class->findSlot(key);
+  if (slot >= 0 && slot < m_slots.size()) {
+    return m_slots[slot];
+  }
+  return Object::getField(key);
+}
+
+void ff::ClassInstance::setField(const Symbol& key, Ref<Object> value) {
+  int slot = m_class->findSlot(key);
+  if (slot >= 0 && slot < m_slots.size()) {
+    if (isImmortal()) {
+      throw RuntimeError::createf("Can't set field '%s' of a shared object", key.c_str());
+    }
+    m_slots[slot] = value;
+    return;
+  }
+  Object::setField(key, value);
+}
+
 std::string ff::ClassInstance::toString() const {
   char buffer[32] = {0};
   snprintf(buffer, 32, "%p", this);
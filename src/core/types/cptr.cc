@@ -8,12 +8,12 @@ using namespace ff::types;
 
 ff::Ref<ff::CPtrType> ff::CPtrType::m_instance;
 
-ff::CPtrType::CPtrType() : Type("cptr") {
+ff::CPtrType::CPtrType() : Type("cptr", TYPEID_CPTR) {
   // _DEFINE_BINARY_OP("__eq__",  Bool, ==, "bool");
   // _DEFINE_BINARY_OP("__neq__", Bool, !=, "bool");
 
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string( cptr(args[0])->toString() ));
     }, {
       {"self", type("int")}
@@ -21,7 +21,7 @@ ff::CPtrType::CPtrType() : Type("cptr") {
   );
 
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(cptrval(args[0]) != nullptr));
     }, {
       {"self", type("int")}
@@ -29,7 +29,7 @@ ff::CPtrType::CPtrType() : Type("cptr") {
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(cptr(cptrval(args[0])));
     }, {
       {"self", type("cptr")}
@@ -37,7 +37,7 @@ ff::CPtrType::CPtrType() : Type("cptr") {
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       cptrval(args[0]) = cptrval(args[1]);
       return Ref<Object>();
     }, {
@@ -55,8 +55,7 @@ std::string ff::CPtrType::toString() const {
 
 ff::Ref<ff::CPtrType> ff::CPtrType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<CPtrType>();
-    new (m_instance.get()) CPtrType();
+    m_instance = Ref<CPtrType>(new (memory::raw::allocate<CPtrType>()) CPtrType());
   }
   return m_instance;
 }
@@ -12,9 +12,9 @@ using namespace ff::types;
 
 ff::Ref<ff::DictType> ff::DictType::m_instance;
 
-ff::DictType::DictType() : Type("dict") {
+ff::DictType::DictType() : Type("dict", TYPEID_DICT) {
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(args[0].as<Dict>()->toString()));
     }, {
       {"self", type("dict")}
@@ -22,8 +22,13 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("get",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return args[0].as<Dict>()->getField(args[1].as<String>()->value);
+    obj(fn([](VM* context, NativeArgs args) {
+      // Key that was never interned can't be a field, so looking it up doesn't intern it
+      Symbol key;
+      if (!Symbol::find(strval(args[1]), key)) {
+        throw RuntimeError::createf("No such field: '%s'", strval(args[1]).c_str());
+      }
+      return args[0].as<Dict>()->getField(key);
     }, {
       {"self", type("dict")},
       {"key", type("string")}
@@ -31,7 +36,7 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("set",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       args[0].as<Dict>()->setField(args[1].as<String>()->value, args[2]);
       return Ref<Object>();
     }, {
@@ -42,9 +47,9 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("has",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto fields = args[0].as<Dict>()->getFields();
-      return obj(boolean(fields.find(strval(args[1])) != fields.end()));
+    obj(fn([](VM* context, NativeArgs args) {
+      Symbol key;
+      return obj(boolean(Symbol::find(strval(args[1]), key) && args[0].as<const Dict>()->hasField(key)));
     }, {
       {"self", type("dict")},
       {"key", type("string")}
@@ -52,11 +57,11 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("remove",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& fields = args[0].as<Dict>()->getFields();
-      auto itr = fields.find(strval(args[1]));
-      if (itr != fields.end()) {
-        fields.erase(itr);
+    obj(fn([](VM* context, NativeArgs args) {
+      auto self = args[0].as<Dict>();
+      Symbol key;
+      if (Symbol::find(strval(args[1]), key) && self->hasField(key)) {
+        self->getFields().erase(key);
       }
       return Ref<Object>();
     }, {
@@ -66,13 +71,14 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("keys",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       std::vector<Ref<Object>> keys;
+      auto fields = args[0].as<const Dict>()->getSortedFields();
       std::transform(
-        BEGIN_END(args[0].as<Dict>()->getFields()),
+        BEGIN_END(fields),
         std::back_inserter(keys),
         [](const auto& pair) {
-          return obj(string(pair.first));
+          return obj(string(pair.first.str()));
         }
       );
       return obj(vector(keys));
@@ -82,32 +88,35 @@ ff::DictType::DictType() : Type("dict") {
   );
 
   setField("size",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(integer(args[0].as<Dict>()->getFields().size()));
+    obj(fn([](VM* context, NativeArgs args) {
+      return obj(integer(args[0].as<const Dict>()->getFields().size()));
     }, {
       {"self", type("dict")}
     }, type("int")))
   );
 
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(boolean(!args[0].as<Dict>()->getFields().empty()));
+    obj(fn([](VM* context, NativeArgs args) {
+      return obj(boolean(!args[0].as<const Dict>()->getFields().empty()));
     }, {
       {"self", type("dict")}
     }, type("bool")))
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(dict(args[0].as<Dict>()->getFields()));
+    obj(fn([](VM* context, NativeArgs args) {
+      // Shares elements with self until either of them is modified
+      auto result = dict(Dict::ValueType());
+      result->shareFields(*args[0].as<Dict>());
+      return obj(result);
     }, {
       {"self", type("dict")}
     }, type("dict")))
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      args[0].as<Dict>()->getFields() = args[1].as<Dict>()->getFields();
+    obj(fn([](VM* context, NativeArgs args) {
+      args[0].as<Dict>()->shareFields(*args[1].as<Dict>());
       return Ref<Object>();
     }, {
       {"self", type("dict")},
@@ -124,15 +133,14 @@ std::string ff::DictType::toString() const {
 
 ff::Ref<ff::DictType> ff::DictType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<DictType>();
-    new (m_instance.get()) DictType();
+    m_instance = Ref<DictType>(new (memory::raw::allocate<DictType>()) DictType());
   }
   return m_instance;
 }
 
 ff::Dict::Dict(ValueType value) : Instance(DictType::getInstance().asRefTo<Type>()) {
-  for (auto& p : value) {
-    setField(p.first, p.second);
+  if (!value.empty()) {
+    getFields() = std::move(value);
   }
 }
 
@@ -140,10 +148,11 @@ ff::Dict::~Dict() {}
 
 std::string ff::Dict::toString() const {
   std::string result = "{";
+  auto fields = getSortedFields();
   int count = 0;
-  for (auto& p : getFields()) {
-    result += p.first + " -> " + p.second->toString();
-    if (count + 1 < getFields().size()) result += ", ";
+  for (auto& p : fields) {
+    result += p.first.str() + " -> " + p.second->toString();
+    if (count + 1 < fields.size()) result += ", ";
     count++;
   }
   return result + "}";
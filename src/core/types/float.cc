@@ -9,9 +9,9 @@ using namespace ff::types;
 #define _DEFINE_BINARY_OP(name, T, op, ret) \
   do { \
     setField(name, \
-      obj(fn([](VM* context, std::vector<Ref<Object>> args) { \
-        float lhs = floatval(args[0]); \
-        float rhs = 0; \
+      obj(fn([](VM* context, NativeArgs args) { \
+        ff::Float::ValueType lhs = floatval(args[0]); \
+        ff::Float::ValueType rhs = 0; \
         if (isOfType(args[1], FloatType::getInstance())) { \
           rhs = args[1].as<Float>()->value; \
         } else if (isOfType(args[1], IntType::getInstance())) { \
@@ -29,7 +29,7 @@ using namespace ff::types;
 
 ff::Ref<ff::FloatType> ff::FloatType::m_instance;
 
-ff::FloatType::FloatType() : Type("float") {
+ff::FloatType::FloatType() : Type("float", TYPEID_FLOAT) {
   _DEFINE_BINARY_OP("__add__", Float, +, "float");
   _DEFINE_BINARY_OP("__sub__", Float, -, "float");
   _DEFINE_BINARY_OP("__mul__", Float, *, "float");
@@ -42,7 +42,7 @@ ff::FloatType::FloatType() : Type("float") {
   _DEFINE_BINARY_OP("__ge__",  Bool, >=, "bool");
 
   setField("__neg__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(floating(-floatval(args[0])));
     }, {
       {"self", type("float")}
@@ -50,7 +50,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__inc__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto res = floating(floatval(args[0]));
       floatval(args[0])++;
       return obj(res);
@@ -60,7 +60,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__dec__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto res = floating(floatval(args[0]));
       floatval(args[0])--;
       return obj(res);
@@ -70,7 +70,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__as_int__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(integer(floatval(args[0])));
     }, {
       {"self", type("float")}
@@ -78,7 +78,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__as_bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(floatval(args[0]) != 0.0));
     }, {
       {"self", type("float")}
@@ -86,7 +86,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__as_float__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(floating(floatval(args[0])));
     }, {
       {"self", type("float")}
@@ -94,7 +94,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(std::to_string(floatval(args[0]))));
     }, {
       {"self", type("float")}
@@ -102,7 +102,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(floatval(args[0]) != 0));
     }, {
       {"self", type("float")}
@@ -110,7 +110,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(floating(floatval(args[0])));
     }, {
       {"self", type("float")}
@@ -118,7 +118,7 @@ ff::FloatType::FloatType() : Type("float") {
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       floatval(args[0]) = floatval(args[1]);
       return Ref<Object>();
     }, {
@@ -136,8 +136,7 @@ std::string ff::FloatType::toString() const {
 
 ff::Ref<ff::FloatType> ff::FloatType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<FloatType>();
-    new (m_instance.get()) FloatType();
+    m_instance = Ref<FloatType>(new (memory::raw::allocate<FloatType>()) FloatType());
   }
   return m_instance;
 }
@@ -4,7 +4,7 @@
 
 ff::Ref<ff::FunctionType> ff::FunctionType::m_instance;
 
-ff::FunctionType::FunctionType() : Type("function") {
+ff::FunctionType::FunctionType() : Type("function", TYPEID_FUNCTION) {
   //
 }
 
@@ -16,8 +16,7 @@ std::string ff::FunctionType::toString() const {
 
 ff::Ref<ff::FunctionType> ff::FunctionType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<FunctionType>();
-    new (m_instance.get()) FunctionType();
+    m_instance = Ref<FunctionType>(new (memory::raw::allocate<FunctionType>()) FunctionType());
   }
   return m_instance;
 }
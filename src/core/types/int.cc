@@ -6,12 +6,15 @@
 
 using namespace ff::types;
 
-#define _DEFINE_BINARY_OP(name, T, op, ret) \
+#define _DEFINE_BINARY_OP(name, T, op, ret) _DEFINE_BINARY_OP_IF(name, T, op, ret, true)
+#define _DEFINE_DIVISION_OP(name, op)        _DEFINE_BINARY_OP_IF(name, Int, op, "int", rhs != 0)
+
+#define _DEFINE_BINARY_OP_IF(name, T, op, ret, cond) \
   do { \
     setField(name, \
-      obj(fn([](VM* context, std::vector<Ref<Object>> args) { \
-        int lhs = intval(args[0]); \
-        int rhs = 0; \
+      obj(fn([](VM* context, NativeArgs args) { \
+        ff::Int::ValueType lhs = intval(args[0]); \
+        ff::Int::ValueType rhs = 0; \
         if (isOfType(args[1], IntType::getInstance())) { \
           rhs = args[1].as<Int>()->value; \
         } else if (isOfType(args[1], FloatType::getInstance())) { \
@@ -19,6 +22,9 @@ using namespace ff::types;
         } else { \
           rhs = intval(Object::cast(context, args[1], "int")); \
         } \
+        if (!(cond)) { \
+          throw RuntimeError::createf("Division by zero"); \
+        } \
         return obj(T::createInstance(lhs op rhs)); \
       }, { \
         {"self", type("int")}, \
@@ -29,12 +35,12 @@ using namespace ff::types;
 
 ff::Ref<ff::IntType> ff::IntType::m_instance;
 
-ff::IntType::IntType() : Type("int") {
+ff::IntType::IntType() : Type("int", TYPEID_INT) {
   _DEFINE_BINARY_OP("__add__", Int, +, "int");
   _DEFINE_BINARY_OP("__sub__", Int, -, "int");
   _DEFINE_BINARY_OP("__mul__", Int, *, "int");
-  _DEFINE_BINARY_OP("__div__", Int, /, "int");
-  _DEFINE_BINARY_OP("__mod__", Int, %, "int");
+  _DEFINE_DIVISION_OP("__div__", /);
+  _DEFINE_DIVISION_OP("__mod__", %);
   _DEFINE_BINARY_OP("__eq__",  Bool, ==, "bool");
   _DEFINE_BINARY_OP("__neq__", Bool, !=, "bool");
   _DEFINE_BINARY_OP("__lt__",  Bool, <,  "bool");
@@ -43,7 +49,7 @@ ff::IntType::IntType() : Type("int") {
   _DEFINE_BINARY_OP("__ge__",  Bool, >=, "bool");
 
   setField("__neg__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(integer(-intval(args[0])));
     }, {
       {"self", type("int")}
@@ -51,7 +57,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__inc__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto res = integer(intval(args[0]));
       intval(args[0])++;
       return obj(res);
@@ -61,7 +67,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__dec__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto res = integer(intval(args[0]));
       intval(args[0])--;
       return obj(res);
@@ -71,7 +77,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__as_int__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(integer(intval(args[0])));
     }, {
       {"self", type("int")}
@@ -79,7 +85,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__as_bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(intval(args[0]) != 0));
     }, {
       {"self", type("int")}
@@ -87,7 +93,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__as_float__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(floating(intval(args[0])));
     }, {
       {"self", type("int")}
@@ -95,7 +101,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(std::to_string(intval(args[0]))));
     }, {
       {"self", type("int")}
@@ -103,7 +109,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(intval(args[0]) != 0));
     }, {
       {"self", type("int")}
@@ -111,7 +117,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(integer(intval(args[0])));
     }, {
       {"self", type("int")}
@@ -119,7 +125,7 @@ ff::IntType::IntType() : Type("int") {
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       intval(args[0]) = intval(args[1]);
       return Ref<Object>();
     }, {
@@ -137,8 +143,7 @@ std::string ff::IntType::toString() const {
 
 ff::Ref<ff::IntType> ff::IntType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<IntType>();
-    new (m_instance.get()) IntType();
+    m_instance = Ref<IntType>(new (memory::raw::allocate<IntType>()) IntType());
   }
   return m_instance;
 }
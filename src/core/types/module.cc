@@ -3,6 +3,7 @@
 #include <ff/compiler/compiler.h>
 #include <ff/compiler/scanner.h>
 #include <ff/compiler/parser.h>
+#include <ff/module_cache.h>
 #include <ff/runtime.h>
 #include <ff/config.h>
 #include <ff/memory.h>
@@ -16,9 +17,9 @@ using namespace ff::types;
 
 ff::Ref<ff::ModuleType> ff::ModuleType::m_instance;
 
-ff::ModuleType::ModuleType() : Type("module") {
+ff::ModuleType::ModuleType() : Type("module", TYPEID_MODULE) {
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string("<module " + args[0].asRefTo<Module>()->name + ">"));
     }, {
       {"self", type("module")}
@@ -34,8 +35,7 @@ std::string ff::ModuleType::toString() const {
 
 ff::Ref<ff::ModuleType> ff::ModuleType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<ModuleType>();
-    new (m_instance.get()) ModuleType();
+    m_instance = Ref<ModuleType>(new (memory::raw::allocate<ModuleType>()) ModuleType());
   }
   return m_instance;
 }
@@ -62,56 +62,72 @@ ff::Ref<ff::Module> ff::Module::createInstance(const std::string& name) {
 ff::Compiler::ModuleInfo ff::loadModule(const std::string& name, const std::string& filename, const std::string& parentModule) {
   Ref<Module> module = Module::createInstance(name);
 
-  std::ifstream sourceFile(filename);
-  if (!sourceFile) {
-    throw CompileError(filename, -1, "Error opening file");
-  }
-  std::string src((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+  bytecode::ModuleImage image;
+  if (!cache::isEnabled() || !cache::load(filename, image)) {
+    std::string src;
+    ast::Node* tree = nullptr;
+    if (!takePrefetchedModule(filename, src, tree)) {
+      std::ifstream sourceFile(filename);
+      if (!sourceFile) {
+        throw CompileError(filename, -1, "Error opening file");
+      }
+      src = std::string((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
 
-  ff::Scanner scanner(filename, src);
-  auto tokens = scanner.tokenize();
+      ff::Scanner scanner(filename, src);
+      auto tokens = scanner.tokenize();
 
-  ff::Parser parser(filename, tokens);
-  auto tree = parser.parse();
+      ff::Parser parser(filename, tokens);
+      tree = parser.parse();
 
-  if (config::get("debug") != "0") {
-    ast::printTree(tree);
-  }
+      prefetchImports(filename, tree);
+    }
+
+    if (config::get("debug") != "0") {
+      ast::printTree(tree);
+    }
 
-  ff::Compiler compiler;
-  compiler.setThisModule(name);
-  compiler.setParentModule(parentModule);
+    ff::Compiler compiler;
+    compiler.setThisModule(name);
+    compiler.setParentModule(parentModule);
 
-  ff::Ref<ff::Code> code = compiler.compile(filename, tree);
+    image.code = compiler.compile(filename, tree);
+    image.var = compiler.getGlobals()[name];
+    for (auto& import : compiler.getImports()) {
+      image.imports.push_back(compiler.getGlobals()[import]);
+    }
+
+    if (config::get("debug") != "0") {
+      printf("=== Code ===\n\\\n");
+      ast::unwrapCode(image.code);
+    }
 
-  if (config::get("debug") != "0") {
-    printf("=== Code ===\n\\\n");
-    ast::unwrapCode(code);
+    if (cache::isEnabled()) {
+      cache::store(filename, src, image);
+    }
   }
 
   ff::VM vm;
-  vm.run(code);
+  vm.run(image.code);
 
-  auto& globals = vm.getGlobals();
+  auto globals = vm.getGlobals();
   if (globals.find(name) == globals.end()) {
     throw CompileError(filename, 1, "Cannot find module '%s'", name.c_str());
   }
 
-  auto& fields = globals[name]->getFields();
+  auto& fields = globals[name].as<const Object>()->getFields();
 
   for (auto& field : fields) {
     module->setField(field.first, field.second);
   }
 
-  Compiler::ModuleInfo result = {name, module, compiler.getGlobals()[name]};
+  Compiler::ModuleInfo result = {name, module, image.var};
 
-  for (auto& import : compiler.getImports()) {
-    if (!isOfType(globals[import], ModuleType::getInstance())) {
+  for (auto& import : image.imports) {
+    if (!isOfType(globals[import.name], ModuleType::getInstance())) {
       throw CompileError(filename, -1, "Import is not a module");
     }
-    result.imports.push_back({import, globals[import].asRefTo<Module>(), compiler.getGlobals()[import]});
+    result.imports.push_back({import.name, globals[import.name].asRefTo<Module>(), import});
   }
 
   return result;
 }
-
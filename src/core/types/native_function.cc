@@ -4,7 +4,7 @@
 
 ff::Ref<ff::NativeFunctionType> ff::NativeFunctionType::m_instance;
 
-ff::NativeFunctionType::NativeFunctionType() : Type("native_function") {
+ff::NativeFunctionType::NativeFunctionType() : Type("native_function", TYPEID_NATIVE_FUNCTION) {
   //
 }
 
@@ -16,8 +16,7 @@ std::string ff::NativeFunctionType::toString() const {
 
 ff::Ref<ff::NativeFunctionType> ff::NativeFunctionType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<NativeFunctionType>();
-    new (m_instance.get()) NativeFunctionType();
+    m_instance = Ref<NativeFunctionType>(new (memory::raw::allocate<NativeFunctionType>()) NativeFunctionType());
   }
   return m_instance;
 }
@@ -25,6 +24,9 @@ ff::Ref<ff::NativeFunctionType> ff::NativeFunctionType::getInstance() {
 ff::NativeFunction::NativeFunction(ValueType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType)
   : Instance(NativeFunctionType::getInstance().asRefTo<Type>()), func(func), args(args), returnType(returnType) {}
 
+ff::NativeFunction::NativeFunction(FastType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType)
+  : Instance(NativeFunctionType::getInstance().asRefTo<Type>()), fastFunc(func), args(args), returnType(returnType) {}
+
 ff::NativeFunction::~NativeFunction() {}
 
 std::vector<ff::Function::Argument>& ff::NativeFunction::getArgs() {
@@ -50,3 +52,7 @@ bool ff::NativeFunction::equals(Ref<Object> other) const {
 ff::Ref<ff::NativeFunction> ff::NativeFunction::createInstance(ValueType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType) {
   return memory::construct<NativeFunction>(func, args, returnType);
 }
+
+ff::Ref<ff::NativeFunction> ff::NativeFunction::createInstance(FastType func, const std::vector<Function::Argument>& args, Ref<TypeAnnotation> returnType) {
+  return memory::construct<NativeFunction>(func, args, returnType);
+}
@@ -11,13 +11,13 @@
 
 using namespace ff::types;
 
-static std::unordered_map<std::string, ff::Ref<ff::String>> g_strings;
+static thread_local std::unordered_map<std::string, ff::Ref<ff::String>> g_strings; // Per isolate, pooled strings are mutable
 
 ff::Ref<ff::StringType> ff::StringType::m_instance;
 
-ff::StringType::StringType() : Type("string") {
+ff::StringType::StringType() : Type("string", TYPEID_STRING) {
   setField("__add__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       std::string rhs;
       if (isOfType(args[1], StringType::getInstance())) {
         rhs = strval(args[1]);
@@ -40,7 +40,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("__eq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean( strval(args[0]) == strval(args[1]) ));
     }, {
       {"self", type("string")},
@@ -49,7 +49,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("__neq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean( strval(args[0]) != strval(args[1]) ));
     }, {
       {"self", type("string")},
@@ -58,7 +58,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("slice",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto start = intval(args[1]);
       auto end = intval(args[2]);
       return obj(string( strval(args[0]).substr(start, end - start) ));
@@ -70,7 +70,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("starts",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean( mrt::str::startsWith(strval(args[0]), strval(args[1])) ));
     }, {
       {"self", type("string")},
@@ -79,7 +79,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("ends",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean( mrt::str::endsWith(strval(args[0]), strval(args[1])) ));
     }, {
       {"self", type("string")},
@@ -88,7 +88,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("has",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean( strval(args[0]).find(strval(args[1])) != std::string::npos ));
     }, {
       {"self", type("string")},
@@ -97,7 +97,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("find",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto index = strval(args[0]).find(strval(args[1]));
       if (index == std::string::npos) {
         return Ref<Object>();
@@ -110,7 +110,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("rfind",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto& sub = strval(args[1]);
       auto index = strval(args[0]).rfind(sub);
       if (index == std::string::npos) {
@@ -124,15 +124,19 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("size",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(integer(strval(args[0]).size()));
     }, {
       {"self", type("string")}
     }, type("int")))
   );
 
+  for (auto name : {"slice", "starts", "ends", "has", "find", "rfind"}) {
+    getField(name).as<NativeFunction>()->borrowsArgs = true;
+  }
+
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(boolean(strval(args[0]).size() != 0));
     }, {
       {"self", type("string")}
@@ -140,7 +144,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(strval(args[0])));
     }, {
       {"self", type("string")}
@@ -148,7 +152,7 @@ ff::StringType::StringType() : Type("string") {
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       strval(args[0]) = strval(args[1]);
       return Ref<Object>();
     }, {
@@ -166,8 +170,7 @@ std::string ff::StringType::toString() const {
 
 ff::Ref<ff::StringType> ff::StringType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<StringType>();
-    new (m_instance.get()) StringType();
+    m_instance = Ref<StringType>(new (memory::raw::allocate<StringType>()) StringType());
   }
   return m_instance;
 }
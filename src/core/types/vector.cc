@@ -10,9 +10,9 @@ using namespace ff::types;
 
 ff::Ref<ff::VectorType> ff::VectorType::m_instance;
 
-ff::VectorType::VectorType() : Type("vector") {
+ff::VectorType::VectorType() : Type("vector", TYPEID_VECTOR) {
   setField("__as_string__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       return obj(string(args[0].as<Vector>()->toString()));
     }, {
       {"self", type("vector")}
@@ -20,9 +20,9 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("__neq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& self = args[0].as<Vector>()->value;
-      auto& other = args[1].as<Vector>()->value;
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& self = args[0].as<Vector>()->value.get();
+      auto& other = args[1].as<Vector>()->value.get();
       if (self.size() != other.size()) {
         return obj(boolean(true));
       }
@@ -39,9 +39,9 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("__eq__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& self = args[0].as<Vector>()->value;
-      auto& other = args[1].as<Vector>()->value;
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& self = args[0].as<Vector>()->value.get();
+      auto& other = args[1].as<Vector>()->value.get();
       if (self.size() != other.size()) {
         return obj(boolean(false));
       }
@@ -58,13 +58,13 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("get",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto self = args[0].as<Vector>();
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& self = args[0].as<Vector>()->value.get();
       int index = args[1].as<Int>()->value;
-      if ((index >= 0 && index >= self->value.size()) || (index < 0 && -index >= self->value.size())) {
+      if ((index >= 0 && index >= self.size()) || (index < 0 && -index >= self.size())) {
         return Ref<Object>();
       }
-      return self->value[index < 0 ? self->value.size() + index : index];
+      return self[index < 0 ? self.size() + index : index];
     }, {
       {"self", type("vector")},
       {"index", type("int")}
@@ -72,11 +72,12 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("set",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       auto self = args[0].as<Vector>();
       int index = args[1].as<Int>()->value;
-      if ((index >= 0 && index < self->value.size()) || (index < 0 && -index < self->value.size())) {
-        self->value[index < 0 ? self->value.size() + index : index] = args[2];
+      size_t size = self->value.get().size();
+      if ((index >= 0 && index < size) || (index < 0 && -index < size)) {
+        self->value.getMutable()[index < 0 ? size + index : index] = args[2];
       }
       return Ref<Object>();
     }, {
@@ -87,8 +88,8 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("append",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      args[0].as<Vector>()->value.push_back(args[1]);
+    obj(fn([](VM* context, NativeArgs args) {
+      args[0].as<Vector>()->value.getMutable().push_back(args[1]);
       return Ref<Object>();
     }, {
       {"self", type("vector")},
@@ -97,9 +98,10 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("pop",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      Ref<Object> result = args[0].as<Vector>()->value.back();
-      args[0].as<Vector>()->value.pop_back();
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& vec = args[0].as<Vector>()->value.getMutable();
+      Ref<Object> result = vec.back();
+      vec.pop_back();
       return result;
     }, {
       {"self", type("vector")}
@@ -107,10 +109,11 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("remove",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& vec = args[0].as<Vector>()->value;
+    obj(fn([](VM* context, NativeArgs args) {
+      auto self = args[0].as<Vector>();
       auto index = intval(args[1]);
-      if (index < vec.size()) {
+      if (index < self->value.get().size()) {
+        auto& vec = self->value.getMutable();
         vec.erase(vec.begin() + index);
       }
       return Ref<Object>();
@@ -121,8 +124,8 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("find",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& vec = args[0].as<Vector>()->value;
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& vec = args[0].as<Vector>()->value.get();
       for (int i = 0; i < vec.size(); i++) {
         if (vec[i]->equals(args[1])) {
           return obj(integer(i));
@@ -136,8 +139,8 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("contains",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      auto& vec = args[0].as<Vector>()->value;
+    obj(fn([](VM* context, NativeArgs args) {
+      auto& vec = args[0].as<Vector>()->value.get();
       for (int i = 0; i < vec.size(); i++) {
         if (vec[i]->equals(args[1])) {
           return obj(boolean(true));
@@ -150,19 +153,25 @@ ff::VectorType::VectorType() : Type("vector") {
     }, type("bool")))
   );
 
+  for (auto name : {"get", "remove", "find", "contains"}) {
+    getField(name).as<NativeFunction>()->borrowsArgs = true;
+  }
+
   setField("size",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(integer(args[0].as<Vector>()->value.size()));
+    obj(fn([](VM* context, NativeArgs args) {
+      return obj(integer(args[0].as<Vector>()->value.get().size()));
     }, {
       {"self", type("vector")}
     }, type("int")))
   );
 
   setField("__add__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       std::vector<Ref<Object>> res;
-      res.insert(res.end(), args[0].as<Vector>()->value.begin(), args[0].as<Vector>()->value.end());
-      res.insert(res.end(), args[1].as<Vector>()->value.begin(), args[1].as<Vector>()->value.end());
+      auto& self = args[0].as<Vector>()->value.get();
+      auto& other = args[1].as<Vector>()->value.get();
+      res.insert(res.end(), self.begin(), self.end());
+      res.insert(res.end(), other.begin(), other.end());
       return obj(vector(res));
     }, {
       {"self", type("vector")},
@@ -171,9 +180,9 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("unique",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       std::vector<Ref<Object>> res;
-      auto& vec = args[0].as<Vector>()->value;
+      auto& vec = args[0].as<Vector>()->value.get();
       for (auto itr = vec.begin(); itr != vec.end(); ++itr) {
         auto ritr = std::find_if(res.begin(), res.end(), [&itr](auto& element) { return element->equals(*itr); });
         if (ritr == res.end()) {
@@ -187,23 +196,24 @@ ff::VectorType::VectorType() : Type("vector") {
   );
 
   setField("__bool__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(boolean(!args[0].as<Vector>()->value.empty()));
+    obj(fn([](VM* context, NativeArgs args) {
+      return obj(boolean(!args[0].as<Vector>()->value.get().empty()));
     }, {
       {"self", type("vector")}
     }, type("bool")))
   );
 
   setField("__copy__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
-      return obj(vector(args[0].as<Vector>()->value));
+    obj(fn([](VM* context, NativeArgs args) {
+      // Shares elements with self until either of them is modified
+      return obj(memory::construct<Vector>(args[0].as<Vector>()->value));
     }, {
       {"self", type("vector")}
     }, type("vector")))
   );
 
   setField("__assign__",
-    obj(fn([](VM* context, std::vector<Ref<Object>> args) {
+    obj(fn([](VM* context, NativeArgs args) {
       args[0].as<Vector>()->value = args[1].as<Vector>()->value;
       return Ref<Object>();
     }, {
@@ -221,21 +231,23 @@ std::string ff::VectorType::toString() const {
 
 ff::Ref<ff::VectorType> ff::VectorType::getInstance() {
   if (!m_instance.get()) {
-    m_instance = memory::allocate<VectorType>();
-    new (m_instance.get()) VectorType();
+    m_instance = Ref<VectorType>(new (memory::raw::allocate<VectorType>()) VectorType());
   }
   return m_instance;
 }
 
 ff::Vector::Vector(const ValueType& value) : Instance(VectorType::getInstance().asRefTo<Type>()), value(value) {}
 
+ff::Vector::Vector(const CopyOnWrite<ValueType>& value) : Instance(VectorType::getInstance().asRefTo<Type>()), value(value) {}
+
 ff::Vector::~Vector() {}
 
 std::string ff::Vector::toString() const {
+  auto& elements = value.get();
   std::string result = "{";
-  for (int i = 0; i < value.size(); i++) {
-    result += value[i]->toString();
-    if (i + 1 < value.size()) result += ", ";
+  for (int i = 0; i < elements.size(); i++) {
+    result += elements[i]->toString();
+    if (i + 1 < elements.size()) result += ", ";
   }
   return result + "}";
 }
@@ -243,7 +255,7 @@ std::string ff::Vector::toString() const {
 bool ff::Vector::equals(Ref<Object> other) const {
   return other->getObjectType() == OTYPE_INSTANCE
       && other.as<Instance>()->getType() == getType()
-      && other.as<Vector>()->value == value;
+      && other.as<Vector>()->value.get() == value.get();
 }
 
 ff::Ref<ff::Vector> ff::Vector::createInstance(const ValueType& value) {
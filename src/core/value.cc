@@ -0,0 +1,38 @@
+#include <ff/value.h>
+#include <ff/types.h>
+#include <type_traits>
+
+static_assert(std::is_same<ff::Int::ValueType, int64_t>::value, "Value stores int inline as int64_t");
+static_assert(std::is_same<ff::Float::ValueType, double>::value, "Value stores float inline as double");
+
+ff::Value ff::Value::unbox(const Ref<Object>& object) {
+  if (object.get() && object->isInstance()) {
+    switch (object.as<Instance>()->getTypeId()) {
+      case TYPEID_INT:   return fromInt(object.as<Int>()->value);
+      case TYPEID_FLOAT: return fromFloat(object.as<Float>()->value);
+      case TYPEID_BOOL:  return fromBool(object.as<Bool>()->value);
+      default:           break;
+    }
+  }
+  return Value(object);
+}
+
+ff::Ref<ff::Object> ff::Value::box() const {
+  switch (m_tag) {
+    case VTAG_INT:    return Int::createInstance(m_int).asRefTo<Object>();
+    case VTAG_FLOAT:  return Float::createInstance(m_float).asRefTo<Object>();
+    case VTAG_BOOL:   return Bool::createInstance(m_bool).asRefTo<Object>();
+    case VTAG_OBJECT: return m_object;
+    default:          return Ref<Object>();
+  }
+}
+
+std::string ff::Value::toString() const {
+  switch (m_tag) {
+    case VTAG_INT:    return std::to_string(m_int);
+    case VTAG_FLOAT:  return std::to_string(m_float);
+    case VTAG_BOOL:   return m_bool ? "true" : "false";
+    case VTAG_OBJECT: return m_object->toString();
+    default:          return "null";
+  }
+}
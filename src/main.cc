@@ -2,54 +2,69 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstdlib>
 #include <cstdio>
 #include <vector>
 #include <string>
+#include <thread>
 
 #include <mrt/file.h>
+#include <mrt/strutils.h>
 #include <ff/compiler/compiler.h>
 #include <ff/compiler/scanner.h>
 #include <ff/compiler/parser.h>
 #include <ff/utils/path.h>
+#include <ff/bytecode.h>
 #include <ff/version.h>
 #include <ff/runtime.h>
+#include <ff/isolate.h>
 #include <ff/config.h>
 #include <ff/ast.h>
 #include <ff/log.h>
 
-static int run(const std::string& filename, std::string src) {
-#ifndef _FF_DEBUG_DONT_CATCH_EXCEPTIONS
-  try {
-#endif
-    ff::Ref<ff::Code> code;
-    {
-      ff::Scanner scanner(filename, src);
-      auto tokens = scanner.tokenize();
+static ff::Ref<ff::Code> compile(const std::string& filename, const std::string& src) {
+  ff::Scanner scanner(filename, src);
+  auto tokens = scanner.tokenize();
 #ifdef _FF_DEBUG_TOKENS
-      if (ff::config::get("debug") != "0") {
-        for (auto& token : tokens) printf("%s(%s) ", ff::tokenTypeToString(token.type).c_str(), token.str.c_str());
-        putchar('\n');
-      }
+  if (ff::config::get("debug") != "0") {
+    for (auto& token : tokens) printf("%s(%s) ", ff::tokenTypeToString(token.type).c_str(), token.str.c_str());
+    putchar('\n');
+  }
 #endif
-      ff::Parser parser(filename, tokens);
-      auto tree = parser.parse();
+  ff::Parser parser(filename, tokens);
+  auto tree = parser.parse();
+  ff::prefetchImports(filename, tree);
 #ifdef _FF_DEBUG_PRINT_TREE
-      if (ff::config::get("debug") != "0") {
-        ff::ast::printTree(tree);
-      }
+  if (ff::config::get("debug") != "0") {
+    ff::ast::printTree(tree);
+  }
 #endif
-      ff::Compiler compiler;
-      code = compiler.compile(filename, tree);
-      ff::ast::deleteTree(tree);
+  ff::Compiler compiler;
+  auto code = compiler.compile(filename, tree);
+  ff::ast::deleteTree(tree);
+  return code;
+}
+
+static int run(const std::string& filename, const std::string& src, const std::string& output) {
+#ifndef _FF_DEBUG_DONT_CATCH_EXCEPTIONS
+  try {
+#endif
+    ff::Ref<ff::Code> code = ff::bytecode::isBytecodeFile(filename) ? ff::bytecode::load(filename) : compile(filename, src);
 #ifdef _FF_DEBUG_DISASM
-      if (ff::config::get("debug") != "0") {
-        printf("=== Code ===\n\\\n");
-        ff::ast::unwrapCode(code);
-      }
+    if (ff::config::get("debug") != "0") {
+      printf("=== Code ===\n\\\n");
+      ff::ast::unwrapCode(code);
+    }
 #endif
+    if (!output.empty()) {
+      ff::bytecode::save(code, output);
+      return 0;
     }
     ff::VM vm;
     vm.runMain(code);
+    if (ff::config::get("copy_stats") != "0") {
+      fprintf(stderr, "copies: %zu\n", ff::VM::getCopyCount());
+    }
     return vm.getReturnCode();
 #ifndef _FF_DEBUG_DONT_CATCH_EXCEPTIONS
   } catch (const ff::ScanError& e) {
@@ -69,6 +84,26 @@ static int run(const std::string& filename, std::string src) {
   return 0;
 }
 
+/* Runs FILE in count isolates at once, each compiles and runs it with its own VM */
+static int runIsolates(const std::string& filename, const std::string& src, size_t count) {
+  std::vector<int> results(count, 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([&filename, &src, &results, i]() {
+      results[i] = run(filename, src, "");
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int result : results) {
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
 static void usage(const char* argv0) {
   fprintf(stderr,
     "ff v%s\n"
@@ -80,13 +115,20 @@ static void usage(const char* argv0) {
     "  -i, --import-dir FOLDER  - Adds a folder to imports\n"
     "  -d, --debug              - Sets debug to 1\n"
     "  -v, --verbose            - Sets verbose to 1\n"
+    "  -c, --compile            - Compiles FILE to bytecode instead of running it\n"
+    "  -o, --output FILE        - Bytecode output file (default is FILE with .ffc extension)\n"
+    "  -j, --isolates N         - Runs FILE in N threads at once, each with its own VM\n"
     "", ff::VERSION, argv0);
 }
 
 int main(int argc, char ** argv) {
   ff::config::initialize();
+  ff::initialize();
 
   std::string filename;
+  std::string output;
+  bool compileOnly = false;
+  size_t isolates = 0;
 
   for (int i = 1; i < argc; i++) {
     if (!strcmp("-h", argv[i]) || !strcmp("--help", argv[i])) {
@@ -122,6 +164,25 @@ int main(int argc, char ** argv) {
       ff::config::set("debug", "1");
     } else if (!strcmp("-v", argv[i]) || !strcmp("--verbose", argv[i])) {
       ff::config::set("verbose", "1");
+    } else if (!strcmp("-c", argv[i]) || !strcmp("--compile", argv[i])) {
+      compileOnly = true;
+    } else if (!strcmp("-o", argv[i]) || !strcmp("--output", argv[i])) {
+      if (i+1 >= argc) {
+        ff::error("Expected FILE after '%s'", argv[i]);
+        return -1;
+      }
+      output = argv[++i];
+    } else if (!strcmp("-j", argv[i]) || !strcmp("--isolates", argv[i])) {
+      if (i+1 >= argc) {
+        ff::error("Expected N after '%s'", argv[i]);
+        return -1;
+      }
+      int count = atoi(argv[++i]);
+      if (count <= 0) {
+        ff::error("Expected a positive number of isolates");
+        return -1;
+      }
+      isolates = count;
     } else {
       if (filename.empty()) {
         filename = argv[i];
@@ -142,6 +203,22 @@ int main(int argc, char ** argv) {
     return 1;
   }
 
+  if (compileOnly && output.empty()) {
+    output = (mrt::str::endsWith(filename, ".ff") ? filename.substr(0, filename.size() - 3) : filename) + ff::bytecode::kExtension;
+  } else if (!compileOnly && !output.empty()) {
+    ff::error("'-o' can only be used with '--compile'");
+    return -1;
+  }
+
+  if (compileOnly && isolates) {
+    ff::error("'--isolates' can't be used with '--compile'");
+    return -1;
+  }
+
+  if (ff::bytecode::isBytecodeFile(filename)) {
+    return isolates ? runIsolates(filename, "", isolates) : run(filename, "", output);
+  }
+
   std::ifstream sourceFile(filename);
   if (!sourceFile) {
     ff::error("Error opening file '%s'\n", filename.c_str());
@@ -150,5 +227,5 @@ int main(int argc, char ** argv) {
 
   std::string source((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
 
-  return run(filename, source);
+  return isolates ? runIsolates(filename, source, isolates) : run(filename, source, output);
 }
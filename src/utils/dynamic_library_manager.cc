@@ -1,23 +1,29 @@
 #include <ff/utils/dynamic_library_manager.h>
 
-std::unordered_map<std::string, ff::Ref<mrt::DynamicLibrary>> ff::DynamicLibraryManager::m_libraries;
+std::unordered_map<std::string, std::shared_ptr<mrt::DynamicLibrary>> ff::DynamicLibraryManager::m_libraries;
+std::mutex ff::DynamicLibraryManager::m_mutex;
 
-void ff::DynamicLibraryManager::setLibrary(const std::string& name, Ref<mrt::DynamicLibrary> library) {
+void ff::DynamicLibraryManager::setLibrary(const std::string& name, std::shared_ptr<mrt::DynamicLibrary> library) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_libraries[name] = library;
 }
 
 bool ff::DynamicLibraryManager::libraryExists(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   return m_libraries.find(name) != m_libraries.end();
 }
 
-ff::Ref<mrt::DynamicLibrary> ff::DynamicLibraryManager::getLibrary(const std::string& name) {
+std::shared_ptr<mrt::DynamicLibrary> ff::DynamicLibraryManager::getLibrary(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   return m_libraries[name];
 }
 
 void ff::DynamicLibraryManager::deleteLibrary(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_libraries.erase(name);
 }
 
 void ff::DynamicLibraryManager::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_libraries.clear();
 }
@@ -0,0 +1,41 @@
+#include <ff/utils/mapped_file.h>
+#include <ff/memory.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+ff::MappedFile::MappedFile(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+ff::MappedFile::~MappedFile() {
+  munmap((void*)m_data, m_size);
+}
+
+const uint8_t* ff::MappedFile::data() const {
+  return m_data;
+}
+
+size_t ff::MappedFile::size() const {
+  return m_size;
+}
+
+ff::Ref<ff::MappedFile> ff::MappedFile::open(const std::string& filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return {};
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return {};
+  }
+
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+
+  return memory::construct<MappedFile>((const uint8_t*)data, (size_t)info.st_size);
+}
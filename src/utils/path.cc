@@ -2,6 +2,9 @@
 #include <mrt/strutils.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 
 #define _MAX_PATH 1024
 
@@ -29,7 +32,7 @@ std::string ff::path::concat(std::string lhs, std::string rhs) {
 }
 
 std::string ff::path::getcwd() {
-  static char cwd[_MAX_PATH];
+  char cwd[_MAX_PATH];
   if (::getcwd(cwd, sizeof(cwd)) != 0) {
     return std::string(cwd);
   }
@@ -41,6 +44,14 @@ std::string ff::path::getFullPath(const std::string& path) {
   return concat(getcwd(), path);
 }
 
+std::string ff::path::getCanonicalPath(const std::string& path) {
+  char result[PATH_MAX];
+  if (realpath(path.c_str(), result)) {
+    return std::string(result);
+  }
+  return getFullPath(path);
+}
+
 std::string ff::path::getFolder(std::string path) {
   size_t pos = path.rfind('/');
   if (pos != std::string::npos) {
@@ -98,3 +109,15 @@ std::string ff::path::getImportFileFromPath(const std::string& file, std::vector
   }
   return file;
 }
+
+bool ff::path::createDirectories(const std::string& path) {
+  for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    std::string folder = path.substr(0, pos);
+    if (!folder.empty() && mkdir(folder.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (pos == std::string::npos) {
+      return true;
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#include <ff/utils/thread_pool.h>
+
+ff::ThreadPool::ThreadPool(size_t threadCount) {
+  for (size_t i = 0; i < threadCount; i++) {
+    m_threads.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ff::ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_jobs.clear();
+  }
+  m_condition.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void ff::ThreadPool::submit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+  }
+  m_condition.notify_one();
+}
+
+size_t ff::ThreadPool::getThreadCount() const {
+  return m_threads.size();
+}
+
+void ff::ThreadPool::work() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      if (m_stop) {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
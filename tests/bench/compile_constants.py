@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# Compile time benchmark: scripts with many distinct constants (int, float and string literals)
+# Generated function is never called, so run time of the script is dominated by compilation
+
+from typing import Final, List
+import os, sys, time, tempfile, subprocess
+
+FOLDER: Final[str] = os.path.dirname(os.path.realpath(__file__))
+TOPDIR: Final[str] = FOLDER + '/../..'
+REPEAT: Final[int] = 3
+
+def generate(count: int) -> str:
+    lines = ['fn constants() -> {', '  var i = 0;', '  var f = 0.5;', '  var s = "s";']
+    for n in range(count):
+        lines.append(f'  i = i + {n};')
+        lines.append(f'  f = f + {n}.5;')
+        lines.append(f'  s = "c{n}";')
+    lines += ['}', '', 'fn main() -> {}', '']
+    return '\n'.join(lines)
+
+def measure(ff: str, filename: str) -> float:
+    best = None
+    for _ in range(REPEAT):
+        start = time.perf_counter()
+        subprocess.run([ff, filename], check=True, stdout=subprocess.DEVNULL)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+def main():
+    if len(sys.argv) < 2 or sys.argv[1] in ['-h', '--help']:
+        print(f'Usage: {sys.argv[0]} PROFILE|FF_BINARY [COUNT...]')
+        sys.exit(1)
+
+    ff = sys.argv[1]
+    if not os.path.isfile(ff):
+        ff = f'{TOPDIR}/target/{sys.argv[1]}/bin/ff'
+    counts: List[int] = [int(arg) for arg in sys.argv[2:]] or [1000, 5000, 10000, 20000]
+
+    print(f'{"literals":>10} {"constants":>10} {"time (s)":>10}')
+    for count in counts:
+        with tempfile.NamedTemporaryFile('w', suffix='.ff', delete=False) as file:
+            file.write(generate(count))
+        try:
+            print(f'{count * 3:>10} {count * 3 + 3:>10} {measure(ff, file.name):>10.3f}')
+        finally:
+            os.unlink(file.name)
+
+if __name__ == '__main__':
+    main()
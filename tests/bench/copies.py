@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+
+# Copy elision benchmark: counts __copy__ calls made by OP_COPY with config 'copy_elision' off and on
+# Every workload runs its loop ITERATIONS times, copies avoided are the difference between the two runs
+
+from typing import Dict, Final, Tuple
+import os, sys, time, tempfile, subprocess
+
+FOLDER: Final[str] = os.path.dirname(os.path.realpath(__file__))
+TOPDIR: Final[str] = FOLDER + '/../..'
+REPEAT: Final[int] = 3
+ITERATIONS: Final[int] = 100000
+
+WORKLOADS: Final[Dict[str, str]] = {
+    'string operands': '''
+    var s = "value";
+    if (s == "value") {
+      s = s + "!";
+    }''',
+    'string methods': '''
+    var s = "key=value";
+    var index = s.find("=");
+    var matches = s.starts("key");''',
+    'vector methods': '''
+    var v = {"a", "b", "c"};
+    var found = v.contains("b");
+    var index = v.find("c");''',
+    'casts': '''
+    var v = {1, 2, 3};
+    var s = v as string;''',
+    # Copies are kept, values are stored in variables
+    'assignments': '''
+    var s = "value";
+    var t = s;''',
+}
+
+def generate(body: str) -> str:
+    return '\n'.join([
+        'fn main() -> {',
+        f'  for (var i = 0; i < {ITERATIONS}; ++i) {{',
+        body.strip('\n'),
+        '  }',
+        '}',
+        '',
+    ])
+
+def measure(ff: str, filename: str, elision: bool) -> Tuple[int, float]:
+    cmd = [ff, '-s', f'copy_elision={int(elision)}', '-s', 'copy_stats=1', '-s', 'cache_dir=', filename]
+    best = None
+    copies = 0
+    for _ in range(REPEAT):
+        start = time.perf_counter()
+        result = subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+        copies = int(result.stderr.decode('utf-8').split('copies:')[-1])
+    return copies, best
+
+def main():
+    if len(sys.argv) < 2 or sys.argv[1] in ['-h', '--help']:
+        print(f'Usage: {sys.argv[0]} PROFILE|FF_BINARY')
+        sys.exit(1)
+
+    ff = sys.argv[1]
+    if not os.path.isfile(ff):
+        ff = f'{TOPDIR}/target/{sys.argv[1]}/bin/ff'
+
+    print(f'{"workload":>16} {"copies":>10} {"elided":>10} {"avoided":>10} {"time (s)":>10} {"elided (s)":>10}')
+    for name, body in WORKLOADS.items():
+        with tempfile.NamedTemporaryFile('w', suffix='.ff', delete=False) as file:
+            file.write(generate(body))
+        try:
+            copies, elapsed = measure(ff, file.name, False)
+            elidedCopies, elidedElapsed = measure(ff, file.name, True)
+            print(f'{name:>16} {copies:>10} {elidedCopies:>10} {copies - elidedCopies:>10} {elapsed:>10.3f} {elidedElapsed:>10.3f}')
+        finally:
+            os.unlink(file.name)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+# Object size benchmark: bytes of peak RSS per live value, measured with a vector of COUNT values
+# Includes the element of the vector (a single Ref), baseline is the same script with an empty loop
+
+from typing import Dict, Final
+import os, sys, tempfile, subprocess
+
+FOLDER: Final[str] = os.path.dirname(os.path.realpath(__file__))
+TOPDIR: Final[str] = FOLDER + '/../..'
+COUNT: Final[int] = 1000000
+
+WORKLOADS: Final[Dict[str, str]] = {
+    'int': '''
+    v.append(i);''',
+    'float': '''
+    f = f + 1.0;
+    v.append(f);''',
+    'bool': '''
+    v.append(i == 0);''',
+    'dict': '''
+    var d = {"count" -> i, "total" -> i};
+    v.append(d);''',
+}
+
+def generate(body: str, count: int) -> str:
+    return '\n'.join([
+        'fn main() -> {',
+        '  var v = {0};',
+        '  var f = 0.5;',
+        f'  for (var i = 0; i < {count}; ++i) {{',
+        body.strip('\n'),
+        '  }',
+        '}',
+        '',
+    ])
+
+def peakRss(ff: str, body: str, count: int) -> int:
+    with tempfile.NamedTemporaryFile('w', suffix='.ff', delete=False) as file:
+        file.write(generate(body, count))
+    try:
+        process = subprocess.Popen([ff, '-s', 'cache_dir=', file.name], stdout=subprocess.DEVNULL)
+        _, status, usage = os.wait4(process.pid, 0)
+        if status != 0:
+            raise RuntimeError(f'{ff} failed with status {status}')
+        return usage.ru_maxrss * 1024
+    finally:
+        os.unlink(file.name)
+
+def main():
+    if len(sys.argv) < 2 or sys.argv[1] in ['-h', '--help']:
+        print(f'Usage: {sys.argv[0]} PROFILE|FF_BINARY')
+        sys.exit(1)
+
+    ff = sys.argv[1]
+    if not os.path.isfile(ff):
+        ff = f'{TOPDIR}/target/{sys.argv[1]}/bin/ff'
+
+    print(f'{"value":>8} {"bytes":>10}')
+    for name, body in WORKLOADS.items():
+        used = peakRss(ff, body, COUNT) - peakRss(ff, '', COUNT)
+        print(f'{name:>8} {used / COUNT:>10.1f}')
+
+if __name__ == '__main__':
+    main()
@@ -2,7 +2,7 @@
 
 from typing import Dict, Tuple, Final
 from tests import tests
-import os, sys, subprocess
+import os, sys, subprocess, tempfile, shutil
 
 class Color:
     RESET  = "\033[0m"
@@ -42,7 +42,28 @@ def run_cmd(cmd: str) -> Tuple[int, str, str]:
         return e.returncode, e.stdout.decode('utf-8'), e.stderr.decode('utf-8')
 
 def run_test(test: str, test_config: Dict) -> Tuple[bool, int]:
-    result = run_cmd(f'{config["topdir"]}/target/{config["profile"]}/bin/ff {config["script_dir"]}/{test}.ff {test_config.get("args", "")}')
+    ff = f'{config["topdir"]}/target/{config["profile"]}/bin/ff'
+    script = f'{config["script_dir"]}/{test}.ff'
+    if test_config.get('bytecode', False):
+        # Compile to .ffc first and run the bytecode file
+        bytecode = f'{tempfile.gettempdir()}/{test.replace("/", "_")}.ffc'
+        result = run_cmd(f'{ff} --compile {script} -o {bytecode}')
+        if result[0] != 0:
+            return False, result[0]
+        script = bytecode
+    if test_config.get('module_cache', False):
+        # Run with an empty module cache, then again with modules loaded from it, both runs must behave the same
+        cache_dir = tempfile.mkdtemp()
+        try:
+            cmd = f'{ff} -s cache_dir={cache_dir} {script} {test_config.get("args", "")}'
+            cold = run_cmd(cmd)
+            result = run_cmd(cmd)
+        finally:
+            shutil.rmtree(cache_dir)
+        if cold != result:
+            return False, cold[0]
+    else:
+        result = run_cmd(f'{ff} {script} {test_config.get("args", "")}')
     if config['verbose']:
         print(f'{NOTE}: {test}: {result}')
     if test_config['expect'] == 'return':
@@ -17,6 +17,15 @@ tests = {
         'expect': 'return',
         'value': 0
     },
+    'lang/bytecode': {
+        'expect': 'return',
+        'value': 0,
+        'bytecode': True
+    },
+    'lang/class_add_method': {
+        'expect': 'return',
+        'value': 0
+    },
     'lang/class_constructor': {
         'expect': 'return',
         'value': 0
@@ -33,6 +42,10 @@ tests = {
         'expect': 'return',
         'value': 0
     },
+    'lang/class_slots': {
+        'expect': 'return',
+        'value': 0
+    },
     'lang/class_method_arg_order': {
         'expect': 'return',
         'value': 0
@@ -61,10 +74,26 @@ tests = {
         'expect': 'return',
         'value': 1
     },
+    'lang/copy_elision': {
+        'expect': 'return',
+        'value': 0
+    },
+    'lang/copy_on_write': {
+        'expect': 'return',
+        'value': 0
+    },
     'lang/fields': {
         'expect': 'return',
         'value': 0
     },
+    'lang/symbols': {
+        'expect': 'return',
+        'value': 0
+    },
+    'lang/division_by_zero': {
+        'expect': 'return',
+        'value': 1
+    },
     'lang/fn_arg_order': {
         'expect': 'return',
         'value': 0
@@ -106,6 +135,25 @@ tests = {
         'expect': 'return',
         'value': 0
     },
+    'lang/import_cached': {
+        'expect': 'return',
+        'value': 0,
+        'module_cache': True
+    },
+    'lang/import_shared': {
+        'expect': 'stdout',
+        'value': 'module_shared loaded\n'
+    },
+    'lang/import_parallel': {
+        'expect': 'stdout',
+        'value': 'module_shared loaded\n',
+        'args': '-s import_threads=2'
+    },
+    'lang/isolates': {
+        'expect': 'return',
+        'value': 0,
+        'args': '--isolates 8'
+    },
     'lang/loop_for': {
         'expect': 'return',
         'value': 0
@@ -130,6 +178,18 @@ tests = {
         'expect': 'return',
         'value': 0
     },
+    'lang/recursion_deep': {
+        'expect': 'return',
+        'value': 0
+    },
+    'lang/stack_overflow': {
+        'expect': 'return',
+        'value': 1
+    },
+    'lang/tail_call': {
+        'expect': 'return',
+        'value': 0
+    },
     'lang/var_global': {
         'expect': 'return',
         'value': 0